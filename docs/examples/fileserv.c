@@ -22,8 +22,12 @@ static enum PSCHSL_Ctx_CBStatus callback(struct PSCHSL_Ctx* ctx, void* userdata)
             PSCHSL_Resp_SetStatus(ctx, 400, NULL);
             return PSCHSL_CTX_CBSTATUS_OK;
         }
-        size_t len = strlen(path) + 1;
-        path = malloc(len + 2);
+        size_t len = strlen(tmppath) + 1;
+        path = PSCHSL_Ctx_Alloc(ctx, len + 2);
+        if (!path) {
+            PSCHSL_Resp_SetStatus(ctx, 500, NULL);
+            return PSCHSL_CTX_CBSTATUS_OK;
+        }
         path[0] = '.';
         path[1] = '/';
         memcpy(path + 2, tmppath, len);
@@ -31,37 +35,23 @@ static enum PSCHSL_Ctx_CBStatus callback(struct PSCHSL_Ctx* ctx, void* userdata)
     struct stat s;
     FILE* f;
     if (stat(path, &s) || !S_ISREG(s.st_mode) || !(f = fopen(path, "rb"))) {
-        free(path);
         PSCHSL_Resp_SetStatus(ctx, 404, NULL);
         return PSCHSL_CTX_CBSTATUS_OK;
     }
-    free(path);
-    char c;
-    while (1) {
-        c = fgetc(f);
-        if (c == EOF) break;
-        if (!isprint(c)) {
-            PSCHSL_Resp_SetHeader(ctx, "Content-Type", "application/octet-stream");
-            fseek(f, 0, SEEK_END);
-            goto not_text;
-        }
-    }
-    PSCHSL_Resp_SetHeader(ctx, "Content-Type", "text/plain");
-    not_text:;
-    long sz = ftell(f);
     char buf[512];
-    snprintf(buf, 512, "%zu", sz);
-    PSCHSL_Resp_SetHeader(ctx, "Content-Length", buf);
-    fseek(f, 0, SEEK_SET);
-    while (sz >= 512) {
-        fread(buf, 1, 512, f);
-        PSCHSL_Resp_PutBytes(ctx, 512, buf);
-        sz -= 512;
-    }
-    if (sz) {
-        fread(buf, 1, sz, f);
-        PSCHSL_Resp_PutBytes(ctx, sz, buf);
+    size_t sz = fread(buf, 1, sizeof(buf), f);
+    fclose(f);
+    const char* type = "text/plain";
+    for (size_t i = 0; i < sz; ++i) {
+        if (!isprint((unsigned char)buf[i]) && !isspace((unsigned char)buf[i])) {
+            type = "application/octet-stream";
+            break;
+        }
     }
+    // set before PutFile as IMMEMIT sends the headers once the content starts
+    PSCHSL_Resp_SetHeader(ctx, "Content-Type", type);
+    // the file may have failed partway through sending, so the response cannot be replaced with an error
+    if (!PSCHSL_Resp_PutFile(ctx, path)) return PSCHSL_CTX_CBSTATUS_ABORT;
     return PSCHSL_CTX_CBSTATUS_OK;
 }
 
@@ -70,7 +60,6 @@ int main() {
     signal(SIGINT, sigh);
     PSCHSL_SetOpt(state, PSCHSL_OPT_DEFAULTCTXOPT, PSCHSL_CTX_OPT_AUTOCONTENTTYPEHDR, 0);
     PSCHSL_SetOpt(state, PSCHSL_OPT_DEFAULTCTXOPT, PSCHSL_CTX_OPT_IMMEMIT, 1);
-    PSCHSL_SetOpt(state, PSCHSL_OPT_DEFAULTCTXOPT, PSCHSL_CTX_OPT_OPTIPATH, 1);
     PSCHSL_SetRqstHandler("GET", callback, NULL);
     PSCHSL_Run(state);
     PSCHSL_Delete(state);
@@ -0,0 +1,180 @@
+#include "private/cache.h"
+#include "private/crc.h"
+
+#include <stdlib.h>
+
+// Per-entry bookkeeping charged on top of the key and data
+#define ENTRYOVERHEAD (sizeof(struct respcache_entry) + sizeof(struct respcache_entry*))
+
+static inline struct respcache_shard* getshard(struct respcache* c, uint64_t h) {
+    return &c->shards[h % RESPCACHE_SHARDS];
+}
+static inline size_t getbucket(struct respcache_shard* s, uint64_t h) {
+    return (h / RESPCACHE_SHARDS) & (s->bucketcount - 1);
+}
+static inline size_t entrysize(struct respcache_entry* e) {
+    return ENTRYOVERHEAD + e->keylen + e->datalen;
+}
+
+static void unlinkentry(struct respcache_shard* s, struct respcache_entry* e) {
+    struct respcache_entry** p = &s->buckets[getbucket(s, e->hash)];
+    while (*p != e) p = &(*p)->hnext;
+    *p = e->hnext;
+    if (e->prev) e->prev->next = e->next;
+    else s->head = e->next;
+    if (e->next) e->next->prev = e->prev;
+    else s->tail = e->prev;
+    s->mem -= entrysize(e);
+    --s->count;
+    e->dead = true;
+    if (!e->refs) free(e);
+}
+
+static void grow(struct respcache_shard* s) {
+    size_t nc = s->bucketcount * 2;
+    struct respcache_entry** nb = calloc(nc, sizeof(*nb));
+    if (!nb) return;
+    for (size_t i = 0; i < s->bucketcount; ++i) {
+        struct respcache_entry* e = s->buckets[i];
+        while (e) {
+            struct respcache_entry* n = e->hnext;
+            size_t b = (e->hash / RESPCACHE_SHARDS) & (nc - 1);
+            e->hnext = nb[b];
+            nb[b] = e;
+            e = n;
+        }
+    }
+    free(s->buckets);
+    s->buckets = nb;
+    s->bucketcount = nc;
+}
+
+bool PSCHSL__RespCacheInit(struct respcache* c, size_t maxmem, uint64_t ttl) {
+    c->ttl = ttl;
+    for (unsigned i = 0; i < RESPCACHE_SHARDS; ++i) {
+        struct respcache_shard* s = &c->shards[i];
+        s->bucketcount = 64;
+        s->buckets = calloc(s->bucketcount, sizeof(*s->buckets));
+        if (!s->buckets || !createMutex(&s->lock)) {
+            free(s->buckets);
+            while (i) {
+                --i;
+                destroyMutex(&c->shards[i].lock);
+                free(c->shards[i].buckets);
+            }
+            return false;
+        }
+        s->count = 0;
+        s->head = NULL;
+        s->tail = NULL;
+        s->mem = 0;
+        s->maxmem = maxmem / RESPCACHE_SHARDS;
+    }
+    return true;
+}
+
+void PSCHSL__RespCacheFree(struct respcache* c) {
+    for (unsigned i = 0; i < RESPCACHE_SHARDS; ++i) {
+        struct respcache_shard* s = &c->shards[i];
+        struct respcache_entry* e = s->head;
+        while (e) {
+            struct respcache_entry* n = e->next;
+            free(e);
+            e = n;
+        }
+        free(s->buckets);
+        destroyMutex(&s->lock);
+    }
+}
+
+bool PSCHSL__RespCacheKey(
+    struct sbcharbuf* o, enum respcache_framing f, const char* m, const char* t, const char* const* v, size_t vc
+) {
+    sbcb_clear(o);
+    // the entry holds the status line and connection headers as they were sent, so each framing gets its own entry
+    if (!sbcb_add(o, f)) return false;
+    if (!sbcb_addpartstr(o, m, strlen(m) + 1)) return false;
+    if (!sbcb_addpartstr(o, t, strlen(t) + 1)) return false;
+    for (size_t i = 0; i < vc; ++i) {
+        // mark missing headers so that they do not match empty ones
+        if (!v[i]) {
+            if (!sbcb_add(o, 0)) return false;
+        } else {
+            if (!sbcb_add(o, 1)) return false;
+            if (!sbcb_addpartstr(o, v[i], strlen(v[i]) + 1)) return false;
+        }
+    }
+    return true;
+}
+
+struct respcache_entry* PSCHSL__RespCacheGet(struct respcache* c, const char* k, size_t kl, uint64_t now) {
+    uint64_t h = PSCHSL__ccrc64(0, k, kl);
+    struct respcache_shard* s = getshard(c, h);
+    lockMutex(&s->lock);
+    struct respcache_entry* e = s->buckets[getbucket(s, h)];
+    // the hash is only a hint; the whole key is compared so that crafted collisions cannot poison the cache
+    while (e && (e->hash != h || e->keylen != kl || memcmp(e->key, k, kl))) e = e->hnext;
+    if (!e) goto miss;
+    if (now >= e->expires) {
+        unlinkentry(s, e);
+        goto miss;
+    }
+    if (e != s->head) {
+        e->prev->next = e->next;
+        if (e->next) e->next->prev = e->prev;
+        else s->tail = e->prev;
+        e->prev = NULL;
+        e->next = s->head;
+        s->head->prev = e;
+        s->head = e;
+    }
+    ++e->refs;
+    unlockMutex(&s->lock);
+    return e;
+    miss:;
+    unlockMutex(&s->lock);
+    return NULL;
+}
+
+void PSCHSL__RespCacheRelease(struct respcache* c, struct respcache_entry* e) {
+    struct respcache_shard* s = getshard(c, e->hash);
+    lockMutex(&s->lock);
+    if (!--e->refs && e->dead) free(e);
+    unlockMutex(&s->lock);
+}
+
+bool PSCHSL__RespCachePut(struct respcache* c, const char* k, size_t kl, const void* d, size_t l, uint64_t now) {
+    uint64_t h = PSCHSL__ccrc64(0, k, kl);
+    struct respcache_shard* s = getshard(c, h);
+    size_t sz = ENTRYOVERHEAD + kl + l;
+    if (sz > s->maxmem) return false;
+    struct respcache_entry* ne = malloc(sizeof(*ne) + kl + l);
+    if (!ne) return false;
+    ne->hash = h;
+    ne->expires = now + c->ttl;
+    ne->refs = 0;
+    ne->dead = false;
+    ne->keylen = kl;
+    ne->datalen = l;
+    memcpy(ne->key, k, kl);
+    ne->data = ne->key + kl;
+    memcpy(ne->data, d, l);
+    lockMutex(&s->lock);
+    struct respcache_entry* e = s->buckets[getbucket(s, h)];
+    while (e && (e->hash != h || e->keylen != kl || memcmp(e->key, k, kl))) e = e->hnext;
+    if (e) unlinkentry(s, e);
+    while (s->tail && s->mem + sz > s->maxmem) unlinkentry(s, s->tail);
+    if (s->count >= s->bucketcount * 2) grow(s);
+    size_t b = getbucket(s, h);
+    ne->hnext = s->buckets[b];
+    s->buckets[b] = ne;
+    ne->prev = NULL;
+    ne->next = s->head;
+    if (s->head) s->head->prev = ne;
+    else s->tail = ne;
+    s->head = ne;
+    s->mem += sz;
+    ++s->count;
+    unlockMutex(&s->lock);
+    return true;
+}
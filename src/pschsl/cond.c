@@ -0,0 +1,244 @@
+#include "private/cond.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <strings.h>
+#include <ctype.h>
+
+static const char* const months[12] = {
+    "Jan", "Feb", "Mar", "Apr", "May", "Jun", "Jul", "Aug", "Sep", "Oct", "Nov", "Dec"
+};
+static const char* const wdays[7] = {"Thu", "Fri", "Sat", "Sun", "Mon", "Tue", "Wed"}; // starting at 1970-01-01
+
+// Days since 1970-01-01 for a proleptic Gregorian date
+static long long daysfromcivil(long long y, unsigned m, unsigned d) {
+    y -= (m <= 2);
+    long long era = ((y >= 0) ? y : y - 399) / 400;
+    unsigned yoe = y - era * 400;
+    unsigned doy = (153 * ((m > 2) ? m - 3 : m + 9) + 2) / 5 + d - 1;
+    unsigned doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    return era * 146097 + (long long)doe - 719468;
+}
+static void civilfromdays(long long z, long long* y, unsigned* m, unsigned* d) {
+    z += 719468;
+    long long era = ((z >= 0) ? z : z - 146096) / 146097;
+    unsigned doe = z - era * 146097;
+    unsigned yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+    unsigned doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+    unsigned mp = (5 * doy + 2) / 153;
+    *d = doy - (153 * mp + 2) / 5 + 1;
+    *m = (mp < 10) ? mp + 3 : mp - 9;
+    *y = (long long)yoe + era * 400 + (*m <= 2);
+}
+
+static int parsemonth(const char* s) {
+    for (int i = 0; i < 12; ++i) {
+        if (!strncmp(s, months[i], 3)) return i + 1;
+    }
+    return -1;
+}
+static bool parsetime(const char* s, unsigned* h, unsigned* mi, unsigned* se) {
+    if (!isdigit((unsigned char)s[0]) || !isdigit((unsigned char)s[1]) || s[2] != ':' ||
+        !isdigit((unsigned char)s[3]) || !isdigit((unsigned char)s[4]) || s[5] != ':' ||
+        !isdigit((unsigned char)s[6]) || !isdigit((unsigned char)s[7])) return false;
+    *h = (s[0] - '0') * 10 + s[1] - '0';
+    *mi = (s[3] - '0') * 10 + s[4] - '0';
+    *se = (s[6] - '0') * 10 + s[7] - '0';
+    return (*h < 24 && *mi < 60 && *se < 61);
+}
+static bool parsenum(const char** s, unsigned digits, unsigned* out) {
+    unsigned v = 0;
+    for (unsigned i = 0; i < digits; ++i) {
+        if (!isdigit((unsigned char)**s)) return false;
+        v = v * 10 + (**s - '0');
+        ++*s;
+    }
+    *out = v;
+    return true;
+}
+
+long long PSCHSL__ParseHTTPDate(const char* s) {
+    unsigned d, y, h, mi, se;
+    int m;
+    // every format has a fixed length once the weekday is known, so check it up front and never read past the end
+    size_t l = strlen(s);
+    const char* c = strchr(s, ',');
+    if (c && c - s == 3) {
+        // IMF-fixdate: Sun, 06 Nov 1994 08:49:37 GMT
+        if (l != 29 || s[4] != ' ') return -1;
+        s += 5;
+        if (!parsenum(&s, 2, &d) || *s++ != ' ' || (m = parsemonth(s)) < 0) return -1;
+        s += 3;
+        if (*s++ != ' ' || !parsenum(&s, 4, &y) || *s++ != ' ' || !parsetime(s, &h, &mi, &se)) return -1;
+        if (strcmp(s + 8, " GMT")) return -1;
+    } else if (c) {
+        // RFC 850: Sunday, 06-Nov-94 08:49:37 GMT
+        if (l - (c - s) != 24 || c[1] != ' ') return -1;
+        s = c + 2;
+        if (!parsenum(&s, 2, &d) || *s++ != '-' || (m = parsemonth(s)) < 0) return -1;
+        s += 3;
+        if (*s++ != '-' || !parsenum(&s, 2, &y) || *s++ != ' ' || !parsetime(s, &h, &mi, &se)) return -1;
+        if (strcmp(s + 8, " GMT")) return -1;
+        // two-digit years more than 50 years in the future are in the past (RFC 9110 5.6.7); assume 1970-2069
+        y += (y < 70) ? 2000 : 1900;
+    } else {
+        // asctime: Sun Nov  6 08:49:37 1994
+        if (l != 24 || s[3] != ' ' || (m = parsemonth(s + 4)) < 0 || s[7] != ' ') return -1;
+        s += 8;
+        if (*s == ' ') {
+            ++s;
+            if (!parsenum(&s, 1, &d)) return -1;
+        } else if (!parsenum(&s, 2, &d)) {
+            return -1;
+        }
+        if (*s++ != ' ' || !parsetime(s, &h, &mi, &se)) return -1;
+        s += 8;
+        if (*s++ != ' ' || !parsenum(&s, 4, &y) || *s) return -1;
+    }
+    if (!d || d > 31) return -1;
+    return daysfromcivil(y, m, d) * 86400 + h * 3600 + mi * 60 + se;
+}
+
+static inline char* put2(char* o, unsigned v) {
+    o[0] = '0' + v / 10 % 10;
+    o[1] = '0' + v % 10;
+    return o + 2;
+}
+
+void PSCHSL__FormatHTTPDate(long long t, char o[HTTPDATE_SIZE]) {
+    // dates outside of what 4 digits can hold are clamped
+    if (t < -62167219200LL) t = -62167219200LL;
+    else if (t > 253402300799LL) t = 253402300799LL;
+    long long days = ((t >= 0) ? t : t - 86399) / 86400;
+    unsigned secs = t - days * 86400;
+    long long y;
+    unsigned m, d;
+    civilfromdays(days, &y, &m, &d);
+    char* p = o;
+    memcpy(p, wdays[((days % 7) + 7) % 7], 3);
+    p += 3;
+    *p++ = ',';
+    *p++ = ' ';
+    p = put2(p, d);
+    *p++ = ' ';
+    memcpy(p, months[m - 1], 3);
+    p += 3;
+    *p++ = ' ';
+    p = put2(p, y / 100);
+    p = put2(p, y % 100);
+    *p++ = ' ';
+    p = put2(p, secs / 3600);
+    *p++ = ':';
+    p = put2(p, secs / 60 % 60);
+    *p++ = ':';
+    p = put2(p, secs % 60);
+    memcpy(p, " GMT", 5);
+}
+
+void PSCHSL__MakeFileETag(uint64_t size, long long mtime, char o[40]) {
+    snprintf(o, 40, "\"%llx-%llx\"", (unsigned long long)mtime, (unsigned long long)size);
+}
+
+// Compares two entity tags; weak comparison ignores the W/ prefix while strong comparison requires both to be strong
+static bool etageq(const char* a, size_t al, const char* b, size_t bl, bool weak) {
+    bool aw = (al >= 2 && a[0] == 'W' && a[1] == '/');
+    bool bw = (bl >= 2 && b[0] == 'W' && b[1] == '/');
+    if (!weak && (aw || bw)) return false;
+    if (aw) {a += 2; al -= 2;}
+    if (bw) {b += 2; bl -= 2;}
+    return (al == bl && !memcmp(a, b, al));
+}
+
+bool PSCHSL__ETagListMatches(const char* l, const char* etag, bool weak) {
+    while (*l == ' ' || *l == '\t') ++l;
+    if (*l == '*') return true;
+    if (!etag) return false;
+    size_t el = strlen(etag);
+    while (*l) {
+        while (*l == ' ' || *l == '\t' || *l == ',') ++l;
+        if (!*l) break;
+        const char* t = l;
+        if (l[0] == 'W' && l[1] == '/') l += 2;
+        if (*l != '"') return false;
+        const char* q = strchr(l + 1, '"');
+        if (!q) return false;
+        l = q + 1;
+        if (etageq(t, l - t, etag, el, weak)) return true;
+    }
+    return false;
+}
+
+enum cond_result PSCHSL__CheckConditions(
+    const struct cond_hdrs* c, const char* etag, long long lastmod, bool getorhead
+) {
+    if (c->ifmatch) {
+        if (!PSCHSL__ETagListMatches(c->ifmatch, etag, false)) return COND_FAILED;
+    } else if (c->ifunmodsince && lastmod >= 0) {
+        long long t = PSCHSL__ParseHTTPDate(c->ifunmodsince);
+        if (t >= 0 && lastmod > t) return COND_FAILED;
+    }
+    if (c->ifnonematch) {
+        if (PSCHSL__ETagListMatches(c->ifnonematch, etag, true)) return (getorhead) ? COND_NOTMODIFIED : COND_FAILED;
+    } else if (c->ifmodsince && lastmod >= 0 && getorhead) {
+        long long t = PSCHSL__ParseHTTPDate(c->ifmodsince);
+        if (t >= 0 && lastmod <= t) return COND_NOTMODIFIED;
+    }
+    return COND_OK;
+}
+
+static bool parseu64(const char** s, uint64_t* out) {
+    if (!isdigit((unsigned char)**s)) return false;
+    uint64_t v = 0;
+    do {
+        unsigned dg = **s - '0';
+        if (v > (UINT64_MAX - dg) / 10) return false;
+        v = v * 10 + dg;
+        ++*s;
+    } while (isdigit((unsigned char)**s));
+    *out = v;
+    return true;
+}
+
+enum range_result PSCHSL__CheckRange(
+    const struct cond_hdrs* c, const char* etag, long long lastmod, uint64_t sz, uint64_t* st, uint64_t* l
+) {
+    if (!c->range) return RANGE_NONE;
+    if (c->ifrange) {
+        // If-Range needs an exact strong match, otherwise the whole content is sent
+        const char* ir = c->ifrange;
+        while (*ir == ' ') ++ir;
+        if (*ir == '"' || (ir[0] == 'W' && ir[1] == '/')) {
+            if (!etag || !etageq(ir, strlen(ir), etag, strlen(etag), false)) return RANGE_NONE;
+        } else {
+            long long t = PSCHSL__ParseHTTPDate(ir);
+            if (t < 0 || lastmod < 0 || t != lastmod) return RANGE_NONE;
+        }
+    }
+    const char* s = c->range;
+    if (strncasecmp(s, "bytes=", 6)) return RANGE_NONE;
+    s += 6;
+    while (*s == ' ') ++s;
+    uint64_t a, b;
+    if (*s == '-') {
+        ++s;
+        if (!parseu64(&s, &b)) return RANGE_NONE;
+        if (!b || !sz) return RANGE_UNSATISFIABLE;
+        if (b > sz) b = sz;
+        a = sz - b;
+        b = sz - 1;
+    } else {
+        if (!parseu64(&s, &a) || *s++ != '-') return RANGE_NONE;
+        if (isdigit((unsigned char)*s)) {
+            if (!parseu64(&s, &b) || b < a) return RANGE_NONE;
+        } else {
+            b = UINT64_MAX;
+        }
+        if (a >= sz) return RANGE_UNSATISFIABLE;
+        if (b >= sz) b = sz - 1;
+    }
+    while (*s == ' ') ++s;
+    if (*s) return RANGE_NONE;
+    *st = a;
+    *l = b - a + 1;
+    return RANGE_OK;
+}
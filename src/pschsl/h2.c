@@ -0,0 +1,408 @@
+#include "private/h2.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+static const struct {
+    const char* name;
+    const char* value;
+} hpack_static[] = {
+    {":authority", ""},
+    {":method", "GET"},
+    {":method", "POST"},
+    {":path", "/"},
+    {":path", "/index.html"},
+    {":scheme", "http"},
+    {":scheme", "https"},
+    {":status", "200"},
+    {":status", "204"},
+    {":status", "206"},
+    {":status", "304"},
+    {":status", "400"},
+    {":status", "404"},
+    {":status", "500"},
+    {"accept-charset", ""},
+    {"accept-encoding", "gzip, deflate"},
+    {"accept-language", ""},
+    {"accept-ranges", ""},
+    {"accept", ""},
+    {"access-control-allow-origin", ""},
+    {"age", ""},
+    {"allow", ""},
+    {"authorization", ""},
+    {"cache-control", ""},
+    {"content-disposition", ""},
+    {"content-encoding", ""},
+    {"content-language", ""},
+    {"content-length", ""},
+    {"content-location", ""},
+    {"content-range", ""},
+    {"content-type", ""},
+    {"cookie", ""},
+    {"date", ""},
+    {"etag", ""},
+    {"expect", ""},
+    {"expires", ""},
+    {"from", ""},
+    {"host", ""},
+    {"if-match", ""},
+    {"if-modified-since", ""},
+    {"if-none-match", ""},
+    {"if-range", ""},
+    {"if-unmodified-since", ""},
+    {"last-modified", ""},
+    {"link", ""},
+    {"location", ""},
+    {"max-forwards", ""},
+    {"proxy-authenticate", ""},
+    {"proxy-authorization", ""},
+    {"range", ""},
+    {"referer", ""},
+    {"refresh", ""},
+    {"retry-after", ""},
+    {"server", ""},
+    {"set-cookie", ""},
+    {"strict-transport-security", ""},
+    {"transfer-encoding", ""},
+    {"user-agent", ""},
+    {"vary", ""},
+    {"via", ""},
+    {"www-authenticate", ""}
+};
+#define HPACK_STATICCOUNT (sizeof(hpack_static) / sizeof(*hpack_static))
+
+// RFC 7541 Appendix B as a canonical Huffman code: the symbols sorted by code length (then value), and how many codes
+//   there are of each length
+static const uint16_t huffsyms[257] = {
+    48, 49, 50, 97, 99, 101, 105, 111, 115, 116, 32, 37, 45, 46, 47, 51,
+    52, 53, 54, 55, 56, 57, 61, 65, 95, 98, 100, 102, 103, 104, 108, 109,
+    110, 112, 114, 117, 58, 66, 67, 68, 69, 70, 71, 72, 73, 74, 75, 76,
+    77, 78, 79, 80, 81, 82, 83, 84, 85, 86, 87, 89, 106, 107, 113, 118,
+    119, 120, 121, 122, 38, 42, 44, 59, 88, 90, 33, 34, 40, 41, 63, 39,
+    43, 124, 35, 62, 0, 36, 64, 91, 93, 126, 94, 125, 60, 96, 123, 92,
+    195, 208, 128, 130, 131, 162, 184, 194, 224, 226, 153, 161, 167, 172, 176, 177,
+    179, 209, 216, 217, 227, 229, 230, 129, 132, 133, 134, 136, 146, 154, 156, 160,
+    163, 164, 169, 170, 173, 178, 181, 185, 186, 187, 189, 190, 196, 198, 228, 232,
+    233, 1, 135, 137, 138, 139, 140, 141, 143, 147, 149, 150, 151, 152, 155, 157,
+    158, 165, 166, 168, 174, 175, 180, 182, 183, 188, 191, 197, 231, 239, 9, 142,
+    144, 145, 148, 159, 171, 206, 215, 225, 236, 237, 199, 207, 234, 235, 192, 193,
+    200, 201, 202, 205, 210, 213, 218, 219, 238, 240, 242, 243, 255, 203, 204, 211,
+    212, 214, 221, 222, 223, 241, 244, 245, 246, 247, 248, 250, 251, 252, 253, 254,
+    2, 3, 4, 5, 6, 7, 8, 11, 12, 14, 15, 16, 17, 18, 19, 20,
+    21, 23, 24, 25, 26, 27, 28, 29, 30, 31, 127, 220, 249, 10, 13, 22,
+    256
+};
+static const uint16_t huffcount[31] = {
+    0, 0, 0, 0, 0, 10, 26, 32, 6, 0, 5, 3, 2, 6, 2, 3, 0, 0, 0, 3, 8, 13, 26, 29, 12, 4, 15, 19, 29, 0, 4
+};
+
+int PSCHSL__H2IsPreface(const void* b, size_t l) {
+    if (l >= H2_PREFACELEN) return !memcmp(b, H2_PREFACE, H2_PREFACELEN);
+    if (memcmp(b, H2_PREFACE, l)) return 0;
+    return -1;
+}
+
+void PSCHSL__H2ParseFrameHdr(const uint8_t* in, struct h2frame* f) {
+    f->len = ((uint32_t)in[0] << 16) | ((uint32_t)in[1] << 8) | in[2];
+    f->type = in[3];
+    f->flags = in[4];
+    f->stream = (((uint32_t)in[5] << 24) | ((uint32_t)in[6] << 16) | ((uint32_t)in[7] << 8) | in[8]) & 0x7FFFFFFF;
+}
+
+void PSCHSL__H2PutFrameHdr(uint8_t* out, const struct h2frame* f) {
+    out[0] = f->len >> 16;
+    out[1] = f->len >> 8;
+    out[2] = f->len;
+    out[3] = f->type;
+    out[4] = f->flags;
+    out[5] = (f->stream >> 24) & 0x7F;
+    out[6] = f->stream >> 16;
+    out[7] = f->stream >> 8;
+    out[8] = f->stream;
+}
+
+void PSCHSL__H2DefaultSettings(struct h2settings* s) {
+    s->hdrtablesize = 4096;
+    s->enablepush = 1;
+    s->maxstreams = UINT32_MAX;
+    s->initwindow = H2_DEFAULTWINDOW;
+    s->maxframesize = 16384;
+    s->maxhdrlistsize = UINT32_MAX;
+}
+
+enum h2_error PSCHSL__H2ParseSettings(struct h2settings* s, const uint8_t* in, size_t l) {
+    if (l % 6) return H2_ERR_FRAME_SIZE;
+    for (; l; l -= 6, in += 6) {
+        uint16_t id = ((uint16_t)in[0] << 8) | in[1];
+        uint32_t v = ((uint32_t)in[2] << 24) | ((uint32_t)in[3] << 16) | ((uint32_t)in[4] << 8) | in[5];
+        switch (id) {
+            case 1: s->hdrtablesize = v; break;
+            case 2:
+                if (v > 1) return H2_ERR_PROTOCOL;
+                s->enablepush = v;
+                break;
+            case 3: s->maxstreams = v; break;
+            case 4:
+                if (v > H2_MAXWINDOW) return H2_ERR_FLOW_CONTROL;
+                s->initwindow = v;
+                break;
+            case 5:
+                if (v < 16384 || v > 16777215) return H2_ERR_PROTOCOL;
+                s->maxframesize = v;
+                break;
+            case 6: s->maxhdrlistsize = v; break;
+            default: break; // unknown settings must be ignored
+        }
+    }
+    return H2_ERR_NONE;
+}
+
+static inline uint8_t* putsetting(uint8_t* o, uint16_t id, uint32_t v) {
+    o[0] = id >> 8;
+    o[1] = id;
+    o[2] = v >> 24;
+    o[3] = v >> 16;
+    o[4] = v >> 8;
+    o[5] = v;
+    return o + 6;
+}
+
+size_t PSCHSL__H2PutSettings(uint8_t* out, const struct h2settings* s) {
+    uint8_t* o = out + H2_FRAMEHDRLEN;
+    o = putsetting(o, 1, s->hdrtablesize);
+    // SETTINGS_ENABLE_PUSH is a client setting; a server sending it (as 1) is a protocol error for the client
+    if (s->maxstreams != UINT32_MAX) o = putsetting(o, 3, s->maxstreams);
+    o = putsetting(o, 4, s->initwindow);
+    o = putsetting(o, 5, s->maxframesize);
+    if (s->maxhdrlistsize != UINT32_MAX) o = putsetting(o, 6, s->maxhdrlistsize);
+    struct h2frame f = {.len = o - out - H2_FRAMEHDRLEN, .type = H2_FRAME_SETTINGS};
+    PSCHSL__H2PutFrameHdr(out, &f);
+    return o - out;
+}
+
+static inline int b64urlval(char c) {
+    if (c >= 'A' && c <= 'Z') return c - 'A';
+    if (c >= 'a' && c <= 'z') return c - 'a' + 26;
+    if (c >= '0' && c <= '9') return c - '0' + 52;
+    if (c == '-') return 62;
+    if (c == '_') return 63;
+    return -1;
+}
+
+size_t PSCHSL__H2DecodeSettingsHdr(const char* in, uint8_t* out, size_t outsz) {
+    size_t o = 0;
+    uint32_t acc = 0;
+    unsigned bits = 0;
+    for (; *in && *in != '='; ++in) {
+        int v = b64urlval(*in);
+        if (v < 0) return SIZE_MAX;
+        acc = (acc << 6) | v;
+        bits += 6;
+        if (bits >= 8) {
+            bits -= 8;
+            if (o == outsz) return SIZE_MAX;
+            out[o++] = acc >> bits;
+        }
+    }
+    return o;
+}
+
+bool PSCHSL__HpackInit(struct hpack* h, size_t maxsize) {
+    h->cap = 16;
+    h->ring = malloc(h->cap * sizeof(*h->ring));
+    if (!h->ring) return false;
+    h->first = 0;
+    h->count = 0;
+    h->size = 0;
+    h->maxsize = maxsize;
+    h->settingsmax = maxsize;
+    sbcb_init(&h->huff[0]);
+    sbcb_init(&h->huff[1]);
+    return true;
+}
+
+static void evict(struct hpack* h, size_t target) {
+    while (h->count && h->size > target) {
+        struct hpack_entry* e = &h->ring[h->first];
+        h->size -= e->namelen + e->vallen + 32;
+        free(e->name);
+        h->first = (h->first + 1) % h->cap;
+        --h->count;
+    }
+}
+
+void PSCHSL__HpackFree(struct hpack* h) {
+    evict(h, 0);
+    free(h->ring);
+    sbcb_dump(&h->huff[0]);
+    sbcb_dump(&h->huff[1]);
+}
+
+static bool addentry(struct hpack* h, const char* n, size_t nl, const char* v, size_t vl) {
+    size_t esz = nl + vl + 32;
+    if (esz > h->maxsize) {
+        // an entry larger than the table just empties it
+        evict(h, 0);
+        return true;
+    }
+    // copy before evicting as the name may point into an entry that is about to be evicted
+    char* d = malloc(nl + vl + 2);
+    if (!d) return false;
+    memcpy(d, n, nl);
+    d[nl] = 0;
+    memcpy(d + nl + 1, v, vl);
+    d[nl + 1 + vl] = 0;
+    evict(h, h->maxsize - esz);
+    if (h->count == h->cap) {
+        size_t ncap = h->cap * 2;
+        struct hpack_entry* r = malloc(ncap * sizeof(*r));
+        if (!r) {
+            free(d);
+            return false;
+        }
+        for (size_t i = 0; i < h->count; ++i) r[i] = h->ring[(h->first + i) % h->cap];
+        free(h->ring);
+        h->ring = r;
+        h->cap = ncap;
+        h->first = 0;
+    }
+    struct hpack_entry* e = &h->ring[(h->first + h->count) % h->cap];
+    e->name = d;
+    e->value = d + nl + 1;
+    e->namelen = nl;
+    e->vallen = vl;
+    h->size += esz;
+    ++h->count;
+    return true;
+}
+
+static bool getentry(struct hpack* h, size_t i, const char** n, size_t* nl, const char** v, size_t* vl) {
+    if (!i) return false;
+    if (i <= HPACK_STATICCOUNT) {
+        *n = hpack_static[i - 1].name;
+        *nl = strlen(*n);
+        *v = hpack_static[i - 1].value;
+        *vl = strlen(*v);
+        return true;
+    }
+    i -= HPACK_STATICCOUNT + 1;
+    if (i >= h->count) return false;
+    struct hpack_entry* e = &h->ring[(h->first + h->count - 1 - i) % h->cap];
+    *n = e->name;
+    *nl = e->namelen;
+    *v = e->value;
+    *vl = e->vallen;
+    return true;
+}
+
+static bool readint(const uint8_t** p, const uint8_t* e, unsigned prefix, size_t* out) {
+    if (*p == e) return false;
+    size_t mask = (1u << prefix) - 1;
+    size_t v = **p & mask;
+    ++*p;
+    if (v < mask) {
+        *out = v;
+        return true;
+    }
+    unsigned shift = 0;
+    while (1) {
+        if (*p == e || shift > 28) return false;
+        uint8_t b = **p;
+        ++*p;
+        v += (size_t)(b & 0x7F) << shift;
+        shift += 7;
+        if (!(b & 0x80)) break;
+    }
+    *out = v;
+    return true;
+}
+
+// Decodes a Huffman-coded string (out must have room for len * 8 / 5 bytes)
+static bool huffdecode(const uint8_t* in, size_t len, char* out, size_t* outlen) {
+    size_t o = 0;
+    unsigned code = 0, first = 0, idx = 0, n = 0;
+    for (size_t i = 0; i < len; ++i) {
+        for (int b = 7; b >= 0; --b) {
+            code |= (in[i] >> b) & 1;
+            ++n;
+            unsigned cnt = huffcount[n];
+            if (code < first + cnt) {
+                unsigned sym = huffsyms[idx + (code - first)];
+                // EOS must not appear in the string
+                if (sym == 256) return false;
+                out[o++] = sym;
+                code = 0;
+                first = 0;
+                idx = 0;
+                n = 0;
+                continue;
+            }
+            if (n == 30) return false;
+            idx += cnt;
+            first = (first + cnt) << 1;
+            code <<= 1;
+        }
+    }
+    // the padding must be shorter than a byte and be the most significant bits of EOS (all ones)
+    if (n > 7 || (code >> 1) != (1u << n) - 1) return false;
+    *outlen = o;
+    return true;
+}
+
+static bool readstr(struct hpack* h, unsigned slot, const uint8_t** p, const uint8_t* e, const char** s, size_t* l) {
+    if (*p == e) return false;
+    bool huff = (**p & 0x80);
+    size_t len;
+    if (!readint(p, e, 7, &len) || len > (size_t)(e - *p)) return false;
+    if (huff && len) {
+        // most names and values fit the inline storage, so this rarely allocates
+        struct sbcharbuf* b = &h->huff[slot];
+        if (!sbcb_reserve(b, len * 8 / 5)) return false;
+        if (!huffdecode(*p, len, b->data, l)) return false;
+        *s = b->data;
+    } else {
+        *s = (const char*)*p;
+        *l = len;
+    }
+    *p += len;
+    return true;
+}
+
+enum h2_error PSCHSL__HpackDecode(struct hpack* h, const uint8_t* in, size_t len, hpack_cb cb, void* ud) {
+    const uint8_t* p = in;
+    const uint8_t* e = in + len;
+    bool fieldseen = false;
+    while (p < e) {
+        uint8_t b = *p;
+        size_t idx;
+        const char* n;
+        const char* v;
+        size_t nl, vl;
+        if (b & 0x80) {
+            if (!readint(&p, e, 7, &idx) || !getentry(h, idx, &n, &nl, &v, &vl)) return H2_ERR_COMPRESSION;
+            if (!cb(ud, n, nl, v, vl)) return H2_ERR_CANCEL;
+            fieldseen = true;
+        } else if ((b & 0xE0) == 0x20) {
+            // size updates are only allowed at the start of a block
+            if (fieldseen || !readint(&p, e, 5, &idx) || idx > h->settingsmax) return H2_ERR_COMPRESSION;
+            h->maxsize = idx;
+            evict(h, idx);
+        } else {
+            bool incidx = ((b & 0xC0) == 0x40);
+            if (!readint(&p, e, (incidx) ? 6 : 4, &idx)) return H2_ERR_COMPRESSION;
+            if (idx) {
+                const char* tv;
+                size_t tvl;
+                if (!getentry(h, idx, &n, &nl, &tv, &tvl)) return H2_ERR_COMPRESSION;
+            } else {
+                if (!readstr(h, 0, &p, e, &n, &nl)) return H2_ERR_COMPRESSION;
+            }
+            if (!readstr(h, 1, &p, e, &v, &vl)) return H2_ERR_COMPRESSION;
+            if (!cb(ud, n, nl, v, vl)) return H2_ERR_CANCEL;
+            // the name may point into the table, so index only after the callback is done with it
+            if (incidx && !addentry(h, n, nl, v, vl)) return H2_ERR_INTERNAL;
+            fieldseen = true;
+        }
+    }
+    return H2_ERR_NONE;
+}
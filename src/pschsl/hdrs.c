@@ -0,0 +1,101 @@
+#include "private/hdrs.h"
+
+#include <string.h>
+#include <strings.h>
+
+static char* materialize(struct hdrs* h, size_t off, size_t len) {
+    if (len + 1 > h->memmax - h->memused) return NULL;
+    char* s = arena_alloc(h->mem, len + 1);
+    if (!s) return NULL;
+    memcpy(s, h->raw + off, len);
+    s[len] = 0;
+    h->memused += len + 1;
+    return s;
+}
+
+static inline bool namematches(struct hdrs* h, struct hdr* e, const char* name, size_t namelen) {
+    if (e->namelen != namelen) return false;
+    if (e->name) return !strcasecmp(e->name, name);
+    return !strncasecmp(h->raw + e->nameoff, name, namelen);
+}
+
+bool PSCHSL__InitHdrs(struct hdrs* h, struct arena* mem, size_t memmax, size_t maxlen, bool lazy) {
+    VLB_INIT(h->list, 32, return false;);
+    h->raw = NULL;
+    h->mem = mem;
+    h->memused = 0;
+    h->memmax = memmax;
+    h->maxlen = maxlen;
+    h->lazy = lazy;
+    return true;
+}
+
+void PSCHSL__ResetHdrs(struct hdrs* h, const char* raw) {
+    h->raw = raw;
+    h->list.len = 0;
+    h->memused = 0;
+}
+
+void PSCHSL__FreeHdrs(struct hdrs* h) {
+    VLB_FREE(h->list);
+}
+
+enum hdrs_result PSCHSL__AddHdr(struct hdrs* h, size_t nameoff, size_t namelen, size_t valoff, size_t vallen) {
+    if (namelen > h->maxlen || vallen > h->maxlen - namelen) return HDRS_TOOLONG;
+    struct hdr* e;
+    VLB_NEXTPTR(h->list, e, 3, 2, return HDRS_OOM;);
+    e->nameoff = nameoff;
+    e->namelen = namelen;
+    e->valoff = valoff;
+    e->vallen = vallen;
+    if (h->lazy) {
+        e->name = NULL;
+        e->value = NULL;
+        return HDRS_OK;
+    }
+    // eager mode charges everything up front, so going over the limit is an error
+    if (namelen + vallen + 2 > h->memmax - h->memused) {
+        --h->list.len;
+        return HDRS_TOOLONG;
+    }
+    if (!(e->name = materialize(h, nameoff, namelen)) || !(e->value = materialize(h, valoff, vallen))) {
+        --h->list.len;
+        return HDRS_OOM;
+    }
+    return HDRS_OK;
+}
+
+const char* PSCHSL__GetHdr(struct hdrs* h, const char* name) {
+    size_t namelen = strlen(name);
+    for (size_t i = 0; i < h->list.len; ++i) {
+        struct hdr* e = &h->list.data[i];
+        if (!namematches(h, e, name, namelen)) continue;
+        if (!e->value) e->value = materialize(h, e->valoff, e->vallen);
+        return e->value;
+    }
+    return NULL;
+}
+
+size_t PSCHSL__GetHdrCount(struct hdrs* h, const char* name) {
+    if (!name) return h->list.len;
+    size_t namelen = strlen(name);
+    size_t c = 0;
+    for (size_t i = 0; i < h->list.len; ++i) {
+        if (namematches(h, &h->list.data[i], name, namelen)) ++c;
+    }
+    return c;
+}
+
+const char* PSCHSL__GetHdrNameByIndex(struct hdrs* h, size_t i) {
+    if (i >= h->list.len) return NULL;
+    struct hdr* e = &h->list.data[i];
+    if (!e->name) e->name = materialize(h, e->nameoff, e->namelen);
+    return e->name;
+}
+
+const char* PSCHSL__GetHdrByIndex(struct hdrs* h, size_t i) {
+    if (i >= h->list.len) return NULL;
+    struct hdr* e = &h->list.data[i];
+    if (!e->value) e->value = materialize(h, e->valoff, e->vallen);
+    return e->value;
+}
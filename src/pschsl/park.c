@@ -0,0 +1,284 @@
+#include "private/park.h"
+#include "private/atomic.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#ifndef _WIN32
+    #include <errno.h>
+    #include <sys/types.h>
+    #include <sys/socket.h>
+    #include <sys/uio.h>
+#endif
+
+#ifndef MSG_NOSIGNAL
+    #define MSG_NOSIGNAL 0
+#endif
+
+// Max amount of messages to hand to the kernel at once (each can take 3 iovecs)
+#define FLUSHMSGS 32
+
+struct sharedbuf* PSCHSL__SharedBufNew(const void* data, size_t len, unsigned refs) {
+    struct sharedbuf* b = malloc(sizeof(*b) + len);
+    if (!b) return NULL;
+    b->refs = refs;
+    b->len = len;
+    memcpy(b->data, data, len);
+    return b;
+}
+
+void PSCHSL__SharedBufUnref(struct sharedbuf* b) {
+    if (!atomicdec(&b->refs)) free(b);
+}
+
+struct parked* PSCHSL__ParkNew(
+    int fd, bool chunked, size_t maxpend, void (*wake)(struct parked*, void*), void* wakeud
+) {
+    struct parked* p = malloc(sizeof(*p));
+    if (!p) return NULL;
+    mpsc_init(&p->q);
+    p->refs = 1;
+    p->notified = false;
+    p->state = 0;
+    p->chunked = chunked;
+    p->fd = fd;
+    p->wake = wake;
+    p->wakeud = wakeud;
+    p->pend = NULL;
+    p->pendtail = NULL;
+    p->off = 0;
+    p->pendsz = 0;
+    p->maxpend = maxpend;
+    return p;
+}
+
+static void freemsg(struct parkmsg* m) {
+    if (m->buf) PSCHSL__SharedBufUnref(m->buf);
+    free(m);
+}
+
+void PSCHSL__ParkRef(struct parked* p) {
+    atomicinc(&p->refs);
+}
+
+void PSCHSL__ParkUnref(struct parked* p) {
+    if (atomicdec(&p->refs)) return;
+    struct mpscnode* n;
+    while ((n = mpsc_pop(&p->q))) freemsg((struct parkmsg*)n);
+    struct parkmsg* m = p->pend;
+    while (m) {
+        struct parkmsg* next = (struct parkmsg*)m->node.next;
+        freemsg(m);
+        m = next;
+    }
+    free(p);
+}
+
+static inline void notify(struct parked* p) {
+    if (!atomicxchg(&p->notified, true) && p->wake) p->wake(p, p->wakeud);
+}
+
+static bool push(struct parked* p, struct sharedbuf* b) {
+    struct parkmsg* m = malloc(sizeof(*m));
+    if (!m) {
+        if (b) PSCHSL__SharedBufUnref(b);
+        return false;
+    }
+    m->buf = b;
+    m->hdrlen = 0;
+    if (p->chunked) {
+        static const char hex[] = "0123456789abcdef";
+        // empty chunks would end the response early, so they are sent as nothing
+        if (b && b->len) {
+            char tmp[16];
+            size_t l = b->len, n = 0;
+            do {
+                tmp[n++] = hex[l & 15];
+                l >>= 4;
+            } while (l);
+            while (n) m->hdr[m->hdrlen++] = tmp[--n];
+            m->hdr[m->hdrlen++] = '\r';
+            m->hdr[m->hdrlen++] = '\n';
+        } else if (!b) {
+            memcpy(m->hdr, "0\r\n\r\n", 5);
+            m->hdrlen = 5;
+        }
+    }
+    mpsc_push(&p->q, &m->node);
+    notify(p);
+    return true;
+}
+
+// Sets PARK_CLOSED; returns false if it was already set
+static bool setclosed(struct parked* p) {
+    unsigned s = atomicload(&p->state);
+    do {
+        if (s & PARK_CLOSED) return false;
+    } while (!atomiccas(&p->state, s, s | PARK_CLOSED));
+    return true;
+}
+
+bool PSCHSL__ParkPush(struct parked* p, struct sharedbuf* b) {
+    // the push is counted before looking at the flag so that ParkEnd cannot slip its end marker in front of it
+    if (atomicinc(&p->state) & PARK_CLOSED) {
+        atomicdec(&p->state);
+        PSCHSL__SharedBufUnref(b);
+        return false;
+    }
+    bool ok = push(p, b);
+    atomicdec(&p->state);
+    return ok;
+}
+
+bool PSCHSL__ParkEnd(struct parked* p) {
+    if (!setclosed(p)) return false;
+    while (atomicload(&p->state) & ~PARK_CLOSED) yield();
+    return push(p, NULL);
+}
+
+void PSCHSL__ParkDetach(struct parked* p) {
+    setclosed(p);
+}
+
+#ifndef _WIN32
+
+static inline size_t msgsize(struct parked* p, struct parkmsg* m) {
+    if (!m->buf) return m->hdrlen;
+    return m->hdrlen + m->buf->len + ((p->chunked && m->buf->len) ? 2 : 0);
+}
+
+static inline size_t addiov(struct iovec* iov, size_t n, const char* d, size_t l, size_t* skip) {
+    if (*skip >= l) {
+        *skip -= l;
+        return n;
+    }
+    iov[n].iov_base = (void*)(d + *skip);
+    iov[n].iov_len = l - *skip;
+    *skip = 0;
+    return n + 1;
+}
+
+// The backlog is only held against the connection once the socket stops taking it, so a big push to a client that
+// keeps up does not count
+static inline enum park_result stalled(struct parked* p) {
+    return (p->maxpend && p->pendsz > p->maxpend) ? PARK_ERROR : PARK_PENDING;
+}
+
+enum park_result PSCHSL__ParkFlush(struct parked* p) {
+    // reset first so that a push racing with this flush wakes the loop up again
+    atomicstore(&p->notified, false);
+    struct mpscnode* n;
+    while ((n = mpsc_pop(&p->q))) {
+        struct parkmsg* m = (struct parkmsg*)n;
+        m->node.next = NULL;
+        if (p->pendtail) p->pendtail->node.next = &m->node;
+        else p->pend = m;
+        p->pendtail = m;
+        p->pendsz += msgsize(p, m);
+    }
+    while (p->pend) {
+        struct iovec iov[FLUSHMSGS * 3];
+        size_t iovs = 0, skip = p->off;
+        struct parkmsg* m = p->pend;
+        for (size_t i = 0; m && i < FLUSHMSGS; ++i, m = (struct parkmsg*)m->node.next) {
+            if (m->hdrlen) iovs = addiov(iov, iovs, m->hdr, m->hdrlen, &skip);
+            if (m->buf && m->buf->len) {
+                iovs = addiov(iov, iovs, m->buf->data, m->buf->len, &skip);
+                if (p->chunked) iovs = addiov(iov, iovs, "\r\n", 2, &skip);
+            }
+        }
+        size_t batch = 0;
+        for (size_t i = 0; i < iovs; ++i) batch += iov[i].iov_len;
+        struct msghdr mh = {0};
+        mh.msg_iov = iov;
+        mh.msg_iovlen = iovs;
+        ssize_t r = sendmsg(p->fd, &mh, MSG_NOSIGNAL);
+        if (r < 0) {
+            if (errno == EINTR) continue;
+            if (errno == EAGAIN || errno == EWOULDBLOCK) return stalled(p);
+            return PARK_ERROR;
+        }
+        size_t w = r;
+        bool shortwrite = (w < batch);
+        p->pendsz -= w;
+        w += p->off;
+        while (p->pend && w >= msgsize(p, p->pend)) {
+            m = p->pend;
+            w -= msgsize(p, m);
+            p->pend = (struct parkmsg*)m->node.next;
+            if (!m->buf) {
+                freemsg(m);
+                p->off = 0;
+                p->pendtail = NULL;
+                return PARK_END;
+            }
+            freemsg(m);
+        }
+        if (!p->pend) p->pendtail = NULL;
+        p->off = w;
+        // only a short write means the socket is full; otherwise go on with the next batch
+        if (p->pend && shortwrite) return stalled(p);
+    }
+    return PARK_IDLE;
+}
+
+#endif
+
+bool PSCHSL__ParkGroupInit(struct parkgroup* g) {
+    if (!createMutex(&g->lock)) return false;
+    VLB_INIT(g->members, 16, destroyMutex(&g->lock); return false;);
+    return true;
+}
+
+void PSCHSL__ParkGroupFree(struct parkgroup* g) {
+    for (size_t i = 0; i < g->members.len; ++i) PSCHSL__ParkUnref(g->members.data[i]);
+    VLB_FREE(g->members);
+    destroyMutex(&g->lock);
+}
+
+bool PSCHSL__ParkGroupAdd(struct parkgroup* g, struct parked* p) {
+    bool ok = true;
+    lockMutex(&g->lock);
+    VLB_ADD(g->members, p, 3, 2, ok = false;);
+    unlockMutex(&g->lock);
+    if (ok) PSCHSL__ParkRef(p);
+    return ok;
+}
+
+static inline void delat(struct parkgroup* g, size_t i) {
+    PSCHSL__ParkUnref(g->members.data[i]);
+    // order does not matter, so fill the hole with the last member
+    g->members.data[i] = g->members.data[--g->members.len];
+}
+
+void PSCHSL__ParkGroupDel(struct parkgroup* g, struct parked* p) {
+    lockMutex(&g->lock);
+    for (size_t i = 0; i < g->members.len; ++i) {
+        if (g->members.data[i] == p) {
+            delat(g, i);
+            break;
+        }
+    }
+    unlockMutex(&g->lock);
+}
+
+size_t PSCHSL__ParkGroupBroadcast(struct parkgroup* g, const void* data, size_t len) {
+    size_t sent = 0;
+    lockMutex(&g->lock);
+    if (!g->members.len) goto ret;
+    struct sharedbuf* b = PSCHSL__SharedBufNew(data, len, g->members.len);
+    if (!b) goto ret;
+    for (size_t i = 0; i < g->members.len; ) {
+        struct parked* p = g->members.data[i];
+        if (atomicload(&p->state) & PARK_CLOSED) {
+            PSCHSL__SharedBufUnref(b);
+            delat(g, i);
+            continue;
+        }
+        if (PSCHSL__ParkPush(p, b)) ++sent;
+        ++i;
+    }
+    ret:;
+    unlockMutex(&g->lock);
+    return sent;
+}
@@ -0,0 +1,79 @@
+#ifndef PSCHSL_ARENA_H
+#define PSCHSL_ARENA_H
+
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdlib.h>
+
+// Alignment of every arena allocation (enough for any scalar type)
+#define ARENA_ALIGN 16
+
+struct arena_chunk {
+    struct arena_chunk* next;
+    size_t size;
+    size_t used;
+};
+// The first chunk is kept across arena_reset calls so that a context reused for another request does not have to
+// allocate again
+struct arena {
+    struct arena_chunk* head;
+    size_t chunksz;
+};
+
+#define ARENA__HDRSZ ((sizeof(struct arena_chunk) + ARENA_ALIGN - 1) & ~(size_t)(ARENA_ALIGN - 1))
+#define ARENA__DATA(c) ((char*)(c) + ARENA__HDRSZ)
+
+static inline void arena_init(struct arena* a, size_t chunksz) {
+    a->head = NULL;
+    a->chunksz = chunksz;
+}
+static inline void* arena_alloc(struct arena* a, size_t sz) {
+    if (!sz) sz = 1;
+    if (sz > (size_t)-1 - ARENA__HDRSZ - ARENA_ALIGN) return NULL;
+    sz = (sz + ARENA_ALIGN - 1) & ~(size_t)(ARENA_ALIGN - 1);
+    struct arena_chunk* c = a->head;
+    if (!c || c->size - c->used < sz) {
+        size_t csz = (sz > a->chunksz) ? sz : a->chunksz;
+        c = malloc(ARENA__HDRSZ + csz);
+        if (!c) return NULL;
+        c->size = csz;
+        c->used = 0;
+        if (a->head && sz > a->chunksz) {
+            // oversized allocation; put it behind the head so the head's free space is not thrown away
+            c->next = a->head->next;
+            a->head->next = c;
+        } else {
+            c->next = a->head;
+            a->head = c;
+        }
+    }
+    void* p = ARENA__DATA(c) + c->used;
+    c->used += sz;
+    return p;
+}
+static inline void arena_reset(struct arena* a) {
+    struct arena_chunk* c = a->head;
+    if (!c) return;
+    while (c->next) {
+        struct arena_chunk* n = c->next;
+        c->next = n->next;
+        free(n);
+    }
+    if (c->size > a->chunksz) {
+        free(c);
+        a->head = NULL;
+    } else {
+        c->used = 0;
+    }
+}
+static inline void arena_free(struct arena* a) {
+    struct arena_chunk* c = a->head;
+    while (c) {
+        struct arena_chunk* n = c->next;
+        free(c);
+        c = n;
+    }
+    a->head = NULL;
+}
+
+#endif
@@ -0,0 +1,66 @@
+#ifndef PSCHSL_ATOMIC_H
+#define PSCHSL_ATOMIC_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Atomic ops on plain volatile integers and bools (1, 4 or 8 bytes wide)
+//   - Loads acquire, stores release, and read-modify-writes are acquire-release
+//   - atomicinc and atomicdec return the new value; atomicxchg and atomicfetchadd return the old one
+//   - atomiccas takes the expected value as an lvalue and updates it with the current value on failure
+#ifndef _MSC_VER
+    #define atomicload(p) __atomic_load_n((p), __ATOMIC_ACQUIRE)
+    #define atomicstore(p, v) __atomic_store_n((p), (v), __ATOMIC_RELEASE)
+    #define atomicinc(p) __atomic_add_fetch((p), 1, __ATOMIC_ACQ_REL)
+    #define atomicdec(p) __atomic_sub_fetch((p), 1, __ATOMIC_ACQ_REL)
+    #define atomicfetchadd(p, v) __atomic_fetch_add((p), (v), __ATOMIC_ACQ_REL)
+    #define atomicxchg(p, v) __atomic_exchange_n((p), (v), __ATOMIC_ACQ_REL)
+    #define atomiccas(p, o, n) __atomic_compare_exchange_n((p), &(o), (n), false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)
+    #define atomicacquire() __atomic_thread_fence(__ATOMIC_ACQUIRE)
+#else
+    #include <windows.h>
+    // volatile accesses have acquire/release semantics under MSVC's default /volatile:ms
+    #define atomicload(p) (*(p))
+    #define atomicstore(p, v) ((void)( \
+        (sizeof(*(p)) == 8) ? InterlockedExchange64((volatile LONG64*)(p), (LONG64)(v)) : \
+        (sizeof(*(p)) == 4) ? InterlockedExchange((volatile LONG*)(p), (LONG)(v)) : \
+        InterlockedExchange8((volatile char*)(p), (char)(v)) \
+    ))
+    #define atomicinc(p) ( \
+        (sizeof(*(p)) == 8) ? (uint64_t)InterlockedIncrement64((volatile LONG64*)(p)) : \
+        (uint64_t)(uint32_t)InterlockedIncrement((volatile LONG*)(p)) \
+    )
+    #define atomicdec(p) ( \
+        (sizeof(*(p)) == 8) ? (uint64_t)InterlockedDecrement64((volatile LONG64*)(p)) : \
+        (uint64_t)(uint32_t)InterlockedDecrement((volatile LONG*)(p)) \
+    )
+    #define atomicfetchadd(p, v) ( \
+        (sizeof(*(p)) == 8) ? (uint64_t)InterlockedExchangeAdd64((volatile LONG64*)(p), (LONG64)(v)) : \
+        (uint64_t)(uint32_t)InterlockedExchangeAdd((volatile LONG*)(p), (LONG)(v)) \
+    )
+    #define atomicxchg(p, v) ( \
+        (sizeof(*(p)) == 8) ? (uint64_t)InterlockedExchange64((volatile LONG64*)(p), (LONG64)(v)) : \
+        (sizeof(*(p)) == 4) ? (uint64_t)(uint32_t)InterlockedExchange((volatile LONG*)(p), (LONG)(v)) : \
+        (uint64_t)(uint8_t)InterlockedExchange8((volatile char*)(p), (char)(v)) \
+    )
+    static inline bool atomic__cas64(volatile void* p, void* o, uint64_t n) {
+        uint64_t e = *(uint64_t*)o;
+        uint64_t r = InterlockedCompareExchange64((volatile LONG64*)p, n, e);
+        if (r == e) return true;
+        *(uint64_t*)o = r;
+        return false;
+    }
+    static inline bool atomic__cas32(volatile void* p, void* o, uint32_t n) {
+        uint32_t e = *(uint32_t*)o;
+        uint32_t r = InterlockedCompareExchange((volatile LONG*)p, n, e);
+        if (r == e) return true;
+        *(uint32_t*)o = r;
+        return false;
+    }
+    #define atomiccas(p, o, n) ( \
+        (sizeof(*(p)) == 8) ? atomic__cas64((p), &(o), (n)) : atomic__cas32((p), &(o), (uint32_t)(n)) \
+    )
+    #define atomicacquire() MemoryBarrier()
+#endif
+
+#endif
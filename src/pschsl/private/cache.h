@@ -0,0 +1,67 @@
+#ifndef PSCHSL_CACHE_H
+#define PSCHSL_CACHE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "threading.h"
+#include "charbuf.h"
+
+#define RESPCACHE_SHARDS 16
+
+// Framing a response was serialized with; entries are only replayed to connections that expect the same one
+//   - HTTP/2 responses are never cached since their header blocks depend on the connection's HPACK state
+enum respcache_framing {
+    RESPCACHE_HTTP10,          // HTTP/1.0 without keep-alive
+    RESPCACHE_HTTP10KEEPALIVE, // HTTP/1.0 with "Connection: keep-alive"
+    RESPCACHE_HTTP11,          // HTTP/1.1 with keep-alive
+    RESPCACHE_HTTP11CLOSE      // HTTP/1.1 with "Connection: close"
+};
+
+struct respcache_entry {
+    struct respcache_entry* prev; // LRU list (most recently used first)
+    struct respcache_entry* next;
+    struct respcache_entry* hnext;
+    uint64_t hash;
+    uint64_t expires;
+    unsigned refs;  // Senders holding the entry; it is freed on the last release once dead
+    bool dead;      // Removed from the shard
+    size_t keylen;
+    size_t datalen;
+    char* data;     // Serialized response (status line, headers and body)
+    char key[];
+};
+struct respcache_shard {
+    mutex_t lock;
+    struct respcache_entry** buckets;
+    size_t bucketcount;
+    size_t count;
+    struct respcache_entry* head;
+    struct respcache_entry* tail;
+    size_t mem;
+    size_t maxmem;  // Entries bigger than this are never stored
+};
+struct respcache {
+    struct respcache_shard shards[RESPCACHE_SHARDS];
+    uint64_t ttl;
+};
+
+// maxmem is split evenly between the shards, so a single response can take at most maxmem / RESPCACHE_SHARDS
+bool PSCHSL__RespCacheInit(struct respcache*, size_t maxmem, uint64_t ttl);
+void PSCHSL__RespCacheFree(struct respcache*);
+// Builds a cache key out of the framing, the method, the raw target with query, and the values of the vary headers
+//   - Missing vary headers are passed as NULL
+//   - Build it in an sbcharbuf on the stack; short keys then need no allocation
+bool PSCHSL__RespCacheKey(
+    struct sbcharbuf*, enum respcache_framing, const char* method, const char* target, const char* const* vals, size_t n
+);
+// Looks up a response
+//   - On a hit, the entry must be given back with PSCHSL__RespCacheRelease once its data was sent
+struct respcache_entry* PSCHSL__RespCacheGet(struct respcache*, const char* key, size_t klen, uint64_t now);
+void PSCHSL__RespCacheRelease(struct respcache*, struct respcache_entry*);
+// Stores a response; returns false if it does not fit in its shard or on allocation failure
+bool PSCHSL__RespCachePut(struct respcache*, const char* key, size_t klen, const void* data, size_t len, uint64_t now);
+
+#endif
@@ -98,4 +98,94 @@ static inline char* cb_peek(struct charbuf* b) {
     return b->data;
 }
 
+// Char buffer with inline storage that only goes to the heap once it outgrows it
+//   - data points into the struct while inline, so the struct must not be moved or copied
+#ifndef SBCB_INLINESZ
+    #define SBCB_INLINESZ 64
+#endif
+struct sbcharbuf {
+    char* data;
+    size_t len;
+    size_t size;
+    char inl[SBCB_INLINESZ];
+};
+
+static inline void sbcb_init(struct sbcharbuf* b) {
+    b->data = b->inl;
+    b->size = SBCB_INLINESZ;
+    b->len = 0;
+}
+static inline bool sbcb__grow(struct sbcharbuf* b, size_t need) {
+    size_t sz = b->size;
+    do {sz *= 2;} while (need > sz);
+    char* d;
+    if (b->data == b->inl) {
+        d = malloc(sz);
+        if (!d) return false;
+        memcpy(d, b->inl, b->len);
+    } else {
+        d = realloc(b->data, sz);
+        if (!d) return false;
+    }
+    b->data = d;
+    b->size = sz;
+    return true;
+}
+static inline bool sbcb_add(struct sbcharbuf* b, char c) {
+    if (b->len == b->size && !sbcb__grow(b, b->len + 1)) return false;
+    b->data[b->len++] = c;
+    return true;
+}
+static inline bool sbcb_addpartstr(struct sbcharbuf* b, const char* s, size_t l) {
+    if (b->len + l > b->size && !sbcb__grow(b, b->len + l)) return false;
+    memcpy(b->data + b->len, s, l);
+    b->len += l;
+    return true;
+}
+static inline bool sbcb_addstr(struct sbcharbuf* b, const char* s) {
+    return sbcb_addpartstr(b, s, strlen(s));
+}
+static inline bool sbcb_nullterm(struct sbcharbuf* b) {
+    if (b->len == b->size && !sbcb__grow(b, b->len + 1)) return false;
+    ((volatile char*)b->data)[b->len] = 0;
+    return true;
+}
+static inline char* sbcb_peek(struct sbcharbuf* b) {
+    if (!sbcb_nullterm(b)) return NULL;
+    return b->data;
+}
+static inline void sbcb_clear(struct sbcharbuf* b) {
+    b->len = 0;
+}
+static inline void sbcb_undo(struct sbcharbuf* b, size_t l) {
+    if (l > b->len) {
+        b->len = 0;
+    } else {
+        b->len -= l;
+    }
+}
+static inline void sbcb_dump(struct sbcharbuf* b) {
+    if (b->data != b->inl) free(b->data);
+}
+// Makes room for at least sz chars in total
+static inline bool sbcb_reserve(struct sbcharbuf* b, size_t sz) {
+    return sz <= b->size || sbcb__grow(b, sz);
+}
+// Takes over the storage of a heap charbuf (h must not be used afterwards)
+static inline void sbcb_adopt(struct sbcharbuf* b, struct charbuf* h) {
+    sbcb_dump(b);
+    b->data = h->data;
+    b->len = h->len;
+    b->size = h->size;
+}
+// Moves heap storage out into h and goes back to the inline storage; returns false if there was none
+static inline bool sbcb_release(struct sbcharbuf* b, struct charbuf* h) {
+    if (b->data == b->inl) return false;
+    h->data = b->data;
+    h->len = b->len;
+    h->size = b->size;
+    sbcb_init(b);
+    return true;
+}
+
 #endif
@@ -0,0 +1,48 @@
+#ifndef PSCHSL_COND_H
+#define PSCHSL_COND_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+// Length of an IMF-fixdate ("Sun, 06 Nov 1994 08:49:37 GMT") plus the NUL
+#define HTTPDATE_SIZE 30
+
+enum cond_result {
+    COND_OK,          // Produce the response normally
+    COND_NOTMODIFIED, // Send 304 without content
+    COND_FAILED       // Send 412 without content
+};
+enum range_result {
+    RANGE_NONE,         // Send the whole content
+    RANGE_OK,           // Send 206 with the given slice
+    RANGE_UNSATISFIABLE // Send 416
+};
+// The request headers that conditional requests depend on (NULL if missing)
+struct cond_hdrs {
+    const char* ifmatch;
+    const char* ifunmodsince;
+    const char* ifnonematch;
+    const char* ifmodsince;
+    const char* range;
+    const char* ifrange;
+};
+
+// Parses an IMF-fixdate, RFC 850, or asctime date into a Unix timestamp
+//   - Returns -1 on error
+long long PSCHSL__ParseHTTPDate(const char*);
+void PSCHSL__FormatHTTPDate(long long, char out[HTTPDATE_SIZE]);
+// Makes a strong entity tag out of a file's size and modification time
+void PSCHSL__MakeFileETag(uint64_t size, long long mtime, char out[40]);
+// Checks an entity tag list ("*" or comma-separated tags) against an entity tag
+bool PSCHSL__ETagListMatches(const char* list, const char* etag, bool weak);
+// Evaluates the preconditions in the order given by RFC 9110 section 13.2.2
+//   - etag can be NULL and lastmod can be -1 if the response does not have them
+enum cond_result PSCHSL__CheckConditions(const struct cond_hdrs*, const char* etag, long long lastmod, bool getorhead);
+// Evaluates Range and If-Range for content of the given size
+//   - Only a single range is honored; multiple ranges fall back to sending everything
+enum range_result PSCHSL__CheckRange(
+    const struct cond_hdrs*, const char* etag, long long lastmod, uint64_t size, uint64_t* start, uint64_t* len
+);
+
+#endif
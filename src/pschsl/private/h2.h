@@ -0,0 +1,126 @@
+#ifndef PSCHSL_H2_H
+#define PSCHSL_H2_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "charbuf.h"
+
+#define H2_PREFACE "PRI * HTTP/2.0\r\n\r\nSM\r\n\r\n"
+#define H2_PREFACELEN 24
+#define H2_FRAMEHDRLEN 9
+#define H2_DEFAULTWINDOW 65535
+#define H2_MAXWINDOW 0x7FFFFFFF
+
+enum h2_frametype {
+    H2_FRAME_DATA,
+    H2_FRAME_HEADERS,
+    H2_FRAME_PRIORITY,
+    H2_FRAME_RST_STREAM,
+    H2_FRAME_SETTINGS,
+    H2_FRAME_PUSH_PROMISE,
+    H2_FRAME_PING,
+    H2_FRAME_GOAWAY,
+    H2_FRAME_WINDOW_UPDATE,
+    H2_FRAME_CONTINUATION
+};
+#define H2_FLAG_ENDSTREAM 0x01
+#define H2_FLAG_ACK 0x01
+#define H2_FLAG_ENDHEADERS 0x04
+#define H2_FLAG_PADDED 0x08
+#define H2_FLAG_PRIORITY 0x20
+
+enum h2_error {
+    H2_ERR_NONE,
+    H2_ERR_PROTOCOL,
+    H2_ERR_INTERNAL,
+    H2_ERR_FLOW_CONTROL,
+    H2_ERR_SETTINGS_TIMEOUT,
+    H2_ERR_STREAM_CLOSED,
+    H2_ERR_FRAME_SIZE,
+    H2_ERR_REFUSED_STREAM,
+    H2_ERR_CANCEL,
+    H2_ERR_COMPRESSION,
+    H2_ERR_CONNECT,
+    H2_ERR_ENHANCE_YOUR_CALM,
+    H2_ERR_INADEQUATE_SECURITY,
+    H2_ERR_HTTP_1_1_REQUIRED
+};
+
+struct h2frame {
+    uint32_t len;
+    uint8_t type;
+    uint8_t flags;
+    uint32_t stream;
+};
+struct h2settings {
+    uint32_t hdrtablesize;
+    uint32_t enablepush;
+    uint32_t maxstreams;
+    uint32_t initwindow;
+    uint32_t maxframesize;
+    uint32_t maxhdrlistsize;
+};
+
+// Checks for the client connection preface
+//   - Returns 1 if buf starts with it, 0 if it does not, and -1 if more data is needed to tell
+int PSCHSL__H2IsPreface(const void* buf, size_t len);
+void PSCHSL__H2ParseFrameHdr(const uint8_t* in, struct h2frame*);
+void PSCHSL__H2PutFrameHdr(uint8_t* out, const struct h2frame*);
+void PSCHSL__H2DefaultSettings(struct h2settings*);
+enum h2_error PSCHSL__H2ParseSettings(struct h2settings*, const uint8_t* in, size_t len);
+// Writes the server's SETTINGS frame (returns the amount of bytes written; out must have room for 9 + 5 * 6 bytes)
+//   - enablepush is never sent
+size_t PSCHSL__H2PutSettings(uint8_t* out, const struct h2settings*);
+// Decodes the base64url HTTP2-Settings header of an h2c upgrade request
+//   - Returns the amount of bytes written to out, or SIZE_MAX on error
+size_t PSCHSL__H2DecodeSettingsHdr(const char* in, uint8_t* out, size_t outsz);
+
+// Flow control window (can go negative after a SETTINGS_INITIAL_WINDOW_SIZE change)
+struct h2window {
+    int64_t avail;
+};
+// Returns how much of want may be sent right now on a stream and takes it from both windows
+static inline uint32_t h2_takewindow(struct h2window* conn, struct h2window* stream, uint32_t want) {
+    int64_t a = (conn->avail < stream->avail) ? conn->avail : stream->avail;
+    if (a <= 0) return 0;
+    if ((int64_t)want > a) want = a;
+    conn->avail -= want;
+    stream->avail -= want;
+    return want;
+}
+static inline bool h2_creditwindow(struct h2window* w, uint32_t inc) {
+    if (!inc || w->avail + inc > H2_MAXWINDOW) return false;
+    w->avail += inc;
+    return true;
+}
+
+struct hpack_entry {
+    char* name; // name and value share one allocation
+    char* value;
+    size_t namelen;
+    size_t vallen;
+};
+// HPACK decoder state of one connection
+//   - Must not be moved once initialized (the Huffman buffers start out inline)
+struct hpack {
+    struct hpack_entry* ring;
+    size_t cap;
+    size_t first;
+    size_t count;
+    size_t size;
+    size_t maxsize;     // Current size set with a dynamic table size update
+    size_t settingsmax; // SETTINGS_HEADER_TABLE_SIZE that was sent to the peer
+    struct sbcharbuf huff[2]; // Decoded Huffman-coded name and value of the current field
+};
+// Called for each decoded header field (the strings are not NUL-terminated and are only valid during the call)
+//   - Return false to stop decoding
+typedef bool (*hpack_cb)(void* userdata, const char* name, size_t namelen, const char* value, size_t vallen);
+
+bool PSCHSL__HpackInit(struct hpack*, size_t maxsize);
+void PSCHSL__HpackFree(struct hpack*);
+// Decodes a complete header block
+enum h2_error PSCHSL__HpackDecode(struct hpack*, const uint8_t* in, size_t len, hpack_cb cb, void* userdata);
+
+#endif
@@ -0,0 +1,45 @@
+#ifndef PSCHSL_HDRS_H
+#define PSCHSL_HDRS_H
+
+#include "vlb.h"
+#include "arena.h"
+
+#include <stddef.h>
+#include <stdbool.h>
+
+struct hdr {
+    size_t nameoff;
+    size_t namelen;
+    size_t valoff;
+    size_t vallen;
+    char* name;  // NULL until materialized
+    char* value; // NULL until materialized
+};
+// Request headers stored as offsets into the raw request buffer
+//   - In lazy mode, the raw buffer must stay valid until the request is finished
+struct hdrs {
+    const char* raw;
+    struct VLB(struct hdr) list;
+    struct arena* mem;
+    size_t memused;
+    size_t memmax;
+    size_t maxlen;
+    bool lazy;
+};
+enum hdrs_result {
+    HDRS_OK,
+    HDRS_OOM,
+    HDRS_TOOLONG, // Either MAXRQSTHDRLEN or MAXRQSTHDRMEM was exceeded
+};
+
+bool PSCHSL__InitHdrs(struct hdrs*, struct arena* mem, size_t memmax, size_t maxlen, bool lazy);
+void PSCHSL__ResetHdrs(struct hdrs*, const char* raw);
+void PSCHSL__FreeHdrs(struct hdrs*);
+// Records a header (the name and value offsets are relative to the raw buffer, with the value already trimmed)
+enum hdrs_result PSCHSL__AddHdr(struct hdrs*, size_t nameoff, size_t namelen, size_t valoff, size_t vallen);
+const char* PSCHSL__GetHdr(struct hdrs*, const char* name);
+size_t PSCHSL__GetHdrCount(struct hdrs*, const char* name);
+const char* PSCHSL__GetHdrNameByIndex(struct hdrs*, size_t i);
+const char* PSCHSL__GetHdrByIndex(struct hdrs*, size_t i);
+
+#endif
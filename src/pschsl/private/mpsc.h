@@ -0,0 +1,86 @@
+#ifndef PSCHSL_MPSC_H
+#define PSCHSL_MPSC_H
+
+#include <stddef.h>
+#include <stdbool.h>
+
+#ifdef _MSC_VER
+    #include <windows.h>
+#endif
+
+// Intrusive lock-free multi-producer single-consumer queue (Vyukov)
+//   - Any thread can push; only one thread at a time may pop
+//   - Embed a struct mpscnode in the queued objects
+struct mpscnode {
+    struct mpscnode* volatile next;
+};
+struct mpsc {
+    struct mpscnode* volatile head; // Producers push here
+    struct mpscnode* tail;          // The consumer pops here
+    struct mpscnode stub;
+};
+
+static inline void mpsc__setnext(struct mpscnode* n, struct mpscnode* next) {
+    #ifndef _MSC_VER
+    __atomic_store_n(&n->next, next, __ATOMIC_RELEASE);
+    #else
+    InterlockedExchangePointer((PVOID volatile*)&n->next, next);
+    #endif
+}
+static inline struct mpscnode* mpsc__getnext(struct mpscnode* n) {
+    #ifndef _MSC_VER
+    return __atomic_load_n(&n->next, __ATOMIC_ACQUIRE);
+    #else
+    return n->next;
+    #endif
+}
+
+static inline void mpsc_init(struct mpsc* q) {
+    q->stub.next = NULL;
+    q->head = &q->stub;
+    q->tail = &q->stub;
+}
+static inline void mpsc_push(struct mpsc* q, struct mpscnode* n) {
+    n->next = NULL;
+    #ifndef _MSC_VER
+    struct mpscnode* prev = __atomic_exchange_n(&q->head, n, __ATOMIC_ACQ_REL);
+    #else
+    struct mpscnode* prev = InterlockedExchangePointer((PVOID volatile*)&q->head, n);
+    #endif
+    // the queue is briefly cut here; the consumer sees it as empty until the link is made
+    mpsc__setnext(prev, n);
+}
+// Pops the oldest node
+//   - Returns NULL if the queue is empty or a push is halfway done (the pushing thread will notify again)
+static inline struct mpscnode* mpsc_pop(struct mpsc* q) {
+    struct mpscnode* t = q->tail;
+    struct mpscnode* next = mpsc__getnext(t);
+    if (t == &q->stub) {
+        if (!next) return NULL;
+        q->tail = next;
+        t = next;
+        next = mpsc__getnext(next);
+    }
+    if (next) {
+        q->tail = next;
+        return t;
+    }
+    #ifndef _MSC_VER
+    if (t != __atomic_load_n(&q->head, __ATOMIC_ACQUIRE)) return NULL;
+    #else
+    if (t != q->head) return NULL;
+    #endif
+    // t is the last node; put the stub behind it so that it can be taken out
+    mpsc_push(q, &q->stub);
+    next = mpsc__getnext(t);
+    if (next) {
+        q->tail = next;
+        return t;
+    }
+    return NULL;
+}
+static inline bool mpsc_empty(struct mpsc* q) {
+    return q->tail == &q->stub && !mpsc__getnext(&q->stub);
+}
+
+#endif
@@ -0,0 +1,87 @@
+#ifndef PSCHSL_PARK_H
+#define PSCHSL_PARK_H
+
+#include <stddef.h>
+#include <stdbool.h>
+
+#include "mpsc.h"
+#include "threading.h"
+#include "vlb.h"
+
+// Refcounted immutable buffer so that one event can be queued on many connections without copying it
+struct sharedbuf {
+    volatile unsigned refs;
+    size_t len;
+    char data[];
+};
+
+struct parkmsg {
+    struct mpscnode node;
+    struct sharedbuf* buf; // NULL marks the end of the response
+    unsigned char hdrlen;
+    char hdr[20];          // Chunk size line if the response is chunked
+};
+
+#define PARK_CLOSED 0x80000000U
+
+// A connection whose response is still open but that no thread is handling
+//   - Any thread can push messages; the event loop writes them out
+struct parked {
+    struct mpsc q;
+    volatile unsigned refs;
+    volatile bool notified;
+    volatile unsigned state; // PARK_CLOSED once ended or detached, plus the amount of pushes in progress
+    bool chunked;
+    int fd;
+    // Called (from the pushing thread) when the queue goes from idle to having something to write
+    void (*wake)(struct parked*, void* userdata);
+    void* wakeud;
+    // Only touched by the event loop
+    struct parkmsg* pend;
+    struct parkmsg* pendtail;
+    size_t off;     // Bytes of the first pending message that were already written
+    size_t pendsz;
+    size_t maxpend; // Close the connection if more than this is still waiting after a write (0 for unlimited)
+};
+enum park_result {
+    PARK_IDLE,    // Everything was written
+    PARK_PENDING, // Wait for the socket to become writable
+    PARK_END,     // The response was ended and fully written
+    PARK_ERROR    // The connection failed or fell too far behind
+};
+
+struct parkgroup {
+    mutex_t lock;
+    struct VLB(struct parked*) members;
+};
+
+// Makes a buffer with refs references
+struct sharedbuf* PSCHSL__SharedBufNew(const void* data, size_t len, unsigned refs);
+void PSCHSL__SharedBufUnref(struct sharedbuf*);
+
+// Returns a parked connection with one reference held by the caller, or NULL on failure
+struct parked* PSCHSL__ParkNew(int fd, bool chunked, size_t maxpend, void (*wake)(struct parked*, void*), void* wakeud);
+void PSCHSL__ParkRef(struct parked*);
+void PSCHSL__ParkUnref(struct parked*);
+// Queues a buffer; takes over one reference to it, even on failure
+//   - Returns false if the connection is closed or out of memory
+bool PSCHSL__ParkPush(struct parked*, struct sharedbuf*);
+// Queues the end of the response; no more pushes are accepted afterwards
+//   - Waits for pushes that are already in progress so that nothing gets queued behind the end
+bool PSCHSL__ParkEnd(struct parked*);
+// Marks the connection as gone so that pushes start failing (call from the event loop before unreffing it)
+void PSCHSL__ParkDetach(struct parked*);
+#ifndef _WIN32
+// Takes what was pushed and writes as much as possible; call when woken up or when the socket becomes writable
+enum park_result PSCHSL__ParkFlush(struct parked*);
+#endif
+
+bool PSCHSL__ParkGroupInit(struct parkgroup*);
+void PSCHSL__ParkGroupFree(struct parkgroup*);
+bool PSCHSL__ParkGroupAdd(struct parkgroup*, struct parked*);
+void PSCHSL__ParkGroupDel(struct parkgroup*, struct parked*);
+// Queues one copy of data on every member; members that closed are dropped from the group
+//   - Returns the amount of connections it was queued on
+size_t PSCHSL__ParkGroupBroadcast(struct parkgroup*, const void* data, size_t len);
+
+#endif
@@ -0,0 +1,48 @@
+#ifndef PSCHSL_RATELIMIT_H
+#define PSCHSL_RATELIMIT_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#define RATELIMIT_SHARDS 16
+#define RATELIMIT_MAXBURST 65535
+
+// One token bucket; key is a hash of the client key (0 if the slot is free), and state packs the last refill time
+//   (in ms since the table was made, plus one) in the upper 40 bits and the tokens (in 1/256ths) in the lower 24
+struct rlslot {
+    volatile uint64_t key;
+    volatile uint64_t state;
+};
+struct rlshard {
+    struct rlslot* slots;
+    volatile size_t sweeppos;
+    char pad[64 - sizeof(struct rlslot*) - sizeof(size_t)]; // Keep the shards' hot fields on separate cache lines
+};
+// Lock-free table of token buckets
+//   - Entries that would be refilled to a full bucket anyway are evicted by PSCHSL__RateLimitSweep, so the table only
+//     has to hold the clients that were active recently
+//   - Under contention the limit is approximate (hash collisions share a bucket, and a full probe window lets the
+//     request through)
+struct ratelimit {
+    uint32_t rate;  // Tokens per second
+    uint32_t burst; // Bucket size
+    uint64_t epoch; // us
+    uint64_t seed;
+    size_t shardslots;
+    struct rlshard shards[RATELIMIT_SHARDS];
+};
+
+// Makes a table with room for about slots clients
+bool PSCHSL__RateLimitInit(struct ratelimit*, uint32_t rate, uint32_t burst, size_t slots, uint64_t now);
+void PSCHSL__RateLimitFree(struct ratelimit*);
+// Takes a token from the bucket of the given client key at the given time (us, e.g. the cached loop time)
+//   - Returns 0 if the request is allowed, or the amount of seconds until it would be (for Retry-After)
+unsigned PSCHSL__RateLimitTake(struct ratelimit*, const void* key, size_t keylen, uint64_t now);
+// Checks the next max slots of every shard for stale entries and frees them; call periodically from the event loop
+void PSCHSL__RateLimitSweep(struct ratelimit*, size_t max, uint64_t now);
+// Writes a 429 response with a Retry-After header
+//   - Returns the length written, or 0 if it did not fit
+size_t PSCHSL__RateLimitResp(char* out, size_t outsz, unsigned retryafter);
+
+#endif
@@ -0,0 +1,55 @@
+#ifndef PSCHSL_SCHED_H
+#define PSCHSL_SCHED_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "threading.h"
+
+// Matches enum PSCHSL_Prio
+#define SCHED_CLASSES 3
+
+struct schedjob {
+    struct schedjob* next;
+    uint8_t prio; // 0 is the highest
+    uint64_t queuedat;
+};
+// Request queue of the thread pool with strict priority classes and reserved threads
+//   - A class may start a job only if enough threads stay free to cover what the other classes have reserved but are
+//     not using, so each class always has its reserved threads available and cannot be starved by the others
+struct sched {
+    mutex_t lock;
+    struct {
+        struct schedjob* head;
+        struct schedjob* tail;
+        size_t queued;
+        unsigned running;
+        unsigned wanted;   // Reservation as it was set
+        unsigned reserved; // Part of it that fits in the current amount of threads
+    } classes[SCHED_CLASSES];
+    unsigned threads;
+    unsigned running;
+    size_t queued;
+};
+
+bool PSCHSL__SchedInit(struct sched*, unsigned threads);
+void PSCHSL__SchedFree(struct sched*);
+// Sets the amount of threads serving the queue
+//   - If the reservations no longer leave a thread for unreserved work, they are cut down starting with the lowest
+//     class, and given back once there are enough threads again
+void PSCHSL__SchedSetThreads(struct sched*, unsigned threads);
+// Reserves threads for a class; fails if all the reservations together would not leave a thread for unreserved work
+bool PSCHSL__SchedSetReserve(struct sched*, unsigned prio, unsigned count);
+void PSCHSL__SchedPut(struct sched*, struct schedjob*);
+// Takes the job to run next and counts it as running
+//   - Returns NULL if nothing is queued or nothing queued may start yet
+struct schedjob* PSCHSL__SchedTake(struct sched*);
+// Marks a job taken with PSCHSL__SchedTake as finished
+void PSCHSL__SchedDone(struct sched*, struct schedjob*);
+// Returns how many jobs of a class are waiting (racy; for deciding whether to start more threads)
+static inline size_t sched_queued(struct sched* s, unsigned prio) {
+    return s->classes[prio].queued;
+}
+
+#endif
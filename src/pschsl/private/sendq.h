@@ -0,0 +1,54 @@
+#ifndef PSCHSL_SENDQ_H
+#define PSCHSL_SENDQ_H
+
+#include <stddef.h>
+#include <stdbool.h>
+
+#ifndef _WIN32
+
+struct sendq_chunk {
+    struct sendq_chunk* next;
+    size_t cap;
+    size_t len;
+    size_t off;
+    char data[];
+};
+// Bounded queue of output that could not be written to a non-blocking socket yet
+//   - Producers should stop once the queue reaches highwm and can continue once it drains below lowwm
+struct sendq {
+    struct sendq_chunk* head;
+    struct sendq_chunk* tail;
+    size_t queued;
+    size_t highwm;
+    size_t lowwm;
+    bool more; // If more of the response is coming after what was last put
+};
+enum sendq_result {
+    SENDQ_DONE,    // Everything was written
+    SENDQ_PENDING, // Some output is queued, but the queue is below the high watermark
+    SENDQ_FULL,    // The queue is at or above the high watermark
+    SENDQ_ERROR    // The connection failed
+};
+
+void PSCHSL__SendqInit(struct sendq*, size_t highwm);
+void PSCHSL__SendqFree(struct sendq*);
+// Writes as much as possible right away and queues the rest
+//   - If the queue is already full, nothing is written or queued and SENDQ_FULL is returned; otherwise, all the data is
+//     taken (even if that puts the queue over the high watermark) and SENDQ_DONE or SENDQ_PENDING is returned
+//   - If more is true, the kernel is told that more data follows (MSG_MORE) so it can fill whole segments
+enum sendq_result PSCHSL__SendqPut(struct sendq*, int fd, const void* data, size_t len, bool more);
+// Writes out queued output; call when the socket becomes writable
+enum sendq_result PSCHSL__SendqFlush(struct sendq*, int fd);
+// Blocks until the queue drains below the low watermark or the timeout (in ms, -1 to wait forever) passes
+//   - Only for PSCHSL_CTX_OPT_SENDQBLOCK; by default a full queue is reported to the producer instead
+enum sendq_result PSCHSL__SendqWait(struct sendq*, int fd, int timeout);
+static inline bool sendq_canput(struct sendq* q) {
+    return q->queued < q->highwm;
+}
+static inline bool sendq_resumable(struct sendq* q) {
+    return q->queued <= q->lowwm;
+}
+
+#endif
+
+#endif
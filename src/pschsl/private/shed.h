@@ -0,0 +1,36 @@
+#ifndef PSCHSL_SHED_H
+#define PSCHSL_SHED_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+// Load shedding state
+//   - A limit of 0 means unlimited
+struct shed {
+    unsigned maxconns;
+    unsigned maxinflight;
+    uint64_t maxqdelay;
+    uint64_t acceptpause;
+    volatile unsigned conns;
+    volatile unsigned inflight;
+    volatile uint64_t acceptpausedtill;
+    size_t resplen;
+    char resp[128]; // Precomputed 503 response
+};
+
+void PSCHSL__ShedInit(struct shed*);
+void PSCHSL__ShedSetRetryAfter(struct shed*, unsigned secs);
+// Takes a connection slot; returns false if the connection should be shed (send shed->resp and close it)
+bool PSCHSL__ShedTakeConn(struct shed*);
+void PSCHSL__ShedReleaseConn(struct shed*);
+// Takes an in-flight request slot for a request that was queued at the given time; returns false if it should be shed
+bool PSCHSL__ShedTakeRqst(struct shed*, uint64_t queuedat, uint64_t now);
+void PSCHSL__ShedReleaseRqst(struct shed*);
+// Reports a failed accept; returns true if accepting was paused because the process or system is out of resources
+bool PSCHSL__ShedAcceptFailed(struct shed*, int err, uint64_t now);
+static inline bool shed_acceptpaused(struct shed* s, uint64_t now) {
+    return now < s->acceptpausedtill;
+}
+
+#endif
@@ -0,0 +1,49 @@
+#ifndef PSCHSL_SOCK_H
+#define PSCHSL_SOCK_H
+
+#include <stdbool.h>
+
+#ifndef _WIN32
+
+// Max amount of fds that can be passed in one PSCHSL__SendFds call
+#define SOCK_MAXPASSFDS 64
+
+bool PSCHSL__SendFds(int sock, const int* fds, unsigned count);
+unsigned PSCHSL__RecvFds(int sock, int* fds, unsigned max);
+bool PSCHSL__IsListener(int fd);
+// Returns the CPU that processed the last packet received on the socket, or -1 if unknown
+int PSCHSL__GetSockCpu(int fd);
+// Socket tuning (0 leaves a setting at the system default)
+struct socktune {
+    unsigned deferaccept; // TCP_DEFER_ACCEPT in seconds
+    unsigned fastopen;    // TCP_FASTOPEN queue length
+    unsigned busypoll;    // SO_BUSY_POLL in microseconds
+    int sndbuf;
+    int rcvbuf;
+    bool nodelay;
+};
+
+// Applies the listener-side settings (DEFER_ACCEPT, FASTOPEN, and the buffer sizes that accepted sockets inherit)
+//   - Settings that do not apply to the socket type or platform are skipped
+void PSCHSL__TuneListener(int fd, const struct socktune*);
+// Applies the per-connection settings (NODELAY, BUSY_POLL, buffer sizes)
+void PSCHSL__TuneConn(int fd, const struct socktune*);
+// Accepts up to max pending connections as non-blocking, close-on-exec sockets
+//   - Returns the amount accepted; if that is 0, *err is set to the errno of the failure (EAGAIN if there was nothing)
+unsigned PSCHSL__AcceptBatch(int lfd, int* fds, unsigned max, int* err);
+// Holds back partial frames while a response is being written in several parts (TCP_CORK or TCP_NOPUSH)
+void PSCHSL__SetCork(int fd, bool on);
+
+// Creates a listening TCP socket (addr can be an IPv4 or IPv6 address, or NULL for any)
+//   - Returns the fd, or -1 on failure
+int PSCHSL__ListenTCP(const char* addr, unsigned port, int backlog);
+// Creates a listening Unix domain socket
+//   - A leading '@' makes an abstract socket (Linux only); otherwise a socket file at path is replaced if connecting to
+//     it is refused (nothing listens on it anymore), and the call fails if something still does
+//   - perms is applied to the socket file before listening, or -1 to leave it as-is
+//   - Returns the fd, or -1 on failure
+int PSCHSL__ListenUnix(const char* path, int perms, int backlog);
+
+#endif
+
+#endif
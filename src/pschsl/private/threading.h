@@ -3,6 +3,8 @@
 
 #include <stdbool.h>
 
+#include "atomic.h"
+
 #ifndef PSCHSL_THREADING_USESTDTHREAD
     #if defined(_WIN32) && !defined(PSCHSL_THREADING_USEWINPTHREAD)
         #include <windows.h>
@@ -31,6 +33,8 @@ typedef struct thread_t {
     thrd_t thread;
     #endif
     char* name;
+    unsigned* cpus;
+    unsigned cpucount;
     threadfunc_t func;
     struct thread_data data;
     void* ret;
@@ -45,16 +49,24 @@ typedef pthread_mutex_t mutex_t;
 typedef mtx_t mutex_t;
 #endif
 struct accesslock {
-    volatile unsigned counter; // TODO: make atomic
+    volatile unsigned counter;
     mutex_t lock;
 };
 
 bool PSCHSL__CreateThread(thread_t*, const char* name, threadfunc_t func, void* args);
+bool PSCHSL__CreateThreadOnCpus(
+    thread_t*, const char* name, threadfunc_t func, void* args, const unsigned* cpus, unsigned cpucount
+);
 void PSCHSL__QuitThread(thread_t*);
 void PSCHSL__DestroyThread(thread_t*, void** ret);
+bool PSCHSL__PinCurrentThread(const unsigned* cpus, unsigned cpucount);
+int PSCHSL__GetCurrentCpu(void);
 #define createThread PSCHSL__CreateThread
+#define createThreadOnCpus PSCHSL__CreateThreadOnCpus
 #define quitThread PSCHSL_QuitThread
 #define destroyThread PSCHSL_DestroyThread
+#define pinCurrentThread PSCHSL__PinCurrentThread
+#define getCurrentCpu PSCHSL__GetCurrentCpu
 
 #ifndef PSCHSL_THREADING_USESTDTHREAD
     #if defined(_WIN32) && !defined(PSCHSL_THREADING_USEWINPTHREAD)
@@ -119,7 +131,7 @@ static inline bool createAccessLock(struct accesslock* a) {
 }
 static inline void destroyAccessLock(struct accesslock* a) {
     lockMutex(&a->lock);
-    while (a->counter) {
+    while (atomicload(&a->counter)) {
         unlockMutex(&a->lock);
         yield();
         lockMutex(&a->lock);
@@ -128,17 +140,17 @@ static inline void destroyAccessLock(struct accesslock* a) {
 }
 static inline void acquireReadAccess(struct accesslock* a) {
     lockMutex(&a->lock);
-    ++a->counter;
+    atomicinc(&a->counter);
     unlockMutex(&a->lock);
 }
 static inline void releaseReadAccess(struct accesslock* a) {
     lockMutex(&a->lock);
-    --a->counter;
+    atomicdec(&a->counter);
     unlockMutex(&a->lock);
 }
 static inline void acquireWriteAccess(struct accesslock* a) {
     lockMutex(&a->lock);
-    while (a->counter) {
+    while (atomicload(&a->counter)) {
         unlockMutex(&a->lock);
         yield();
         lockMutex(&a->lock);
@@ -149,24 +161,24 @@ static inline void releaseWriteAccess(struct accesslock* a) {
 }
 static inline void readToWriteAccess(struct accesslock* a) {
     lockMutex(&a->lock);
-    --a->counter;
-    while (a->counter) {
+    atomicdec(&a->counter);
+    while (atomicload(&a->counter)) {
         unlockMutex(&a->lock);
         yield();
         lockMutex(&a->lock);
     }
 }
 static inline void writeToReadAccess(struct accesslock* a) {
-    ++a->counter;
+    atomicinc(&a->counter);
     unlockMutex(&a->lock);
 }
 static inline void yieldReadAccess(struct accesslock* a) {
     lockMutex(&a->lock);
-    --a->counter;
+    atomicdec(&a->counter);
     unlockMutex(&a->lock);
     yield();
     lockMutex(&a->lock);
-    ++a->counter;
+    atomicinc(&a->counter);
     unlockMutex(&a->lock);
 }
 
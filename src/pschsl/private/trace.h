@@ -0,0 +1,76 @@
+#ifndef PSCHSL_TRACE_H
+#define PSCHSL_TRACE_H
+
+#include "time.h"
+#include "atomic.h"
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+// Dump layout (native byte order): magic, u32 version, u32 record size, then for each ring: u32 tid, u32 count, records
+#define TRACE_MAGIC "PSCHSLTR"
+#define TRACE_VERSION 1
+// Records per thread (must be a power of 2)
+#define TRACE_RINGSIZE 4096
+
+enum trace_event {
+    TRACE_ACCEPT,     // arg is unused
+    TRACE_HDRSPARSED, // arg is the amount of headers
+    TRACE_CBSTART,    // arg is unused
+    TRACE_CBEND,      // arg is the enum PSCHSL_Ctx_CBStatus returned
+    TRACE_FIRSTBYTE,  // arg is unused
+    TRACE_CLOSE       // arg is an enum trace_closereason
+};
+enum trace_closereason {
+    TRACE_CLOSE_CLIENT,
+    TRACE_CLOSE_DONE,
+    TRACE_CLOSE_TIMEOUT,
+    TRACE_CLOSE_ERROR,
+    TRACE_CLOSE_ABORT,
+    TRACE_CLOSE_SHED,
+    TRACE_CLOSE_STOP
+};
+
+struct trace_rec {
+    uint64_t time;
+    uint32_t conn;
+    uint16_t event;
+    uint16_t arg;
+};
+struct trace_ring {
+    struct trace_ring* next;
+    uint32_t tid;
+    volatile bool inuse;
+    volatile uint64_t pos;
+    struct trace_rec recs[TRACE_RINGSIZE];
+};
+
+extern volatile bool PSCHSL__traceon;
+#ifndef _MSC_VER
+extern __thread struct trace_ring* PSCHSL__tracering;
+#else
+extern __declspec(thread) struct trace_ring* PSCHSL__tracering;
+#endif
+
+struct trace_ring* PSCHSL__TraceThreadStart(void);
+// Gives the calling thread's ring back to be reused by another thread
+void PSCHSL__TraceThreadEnd(void);
+// Writes a snapshot of every ring (does not stop writers)
+bool PSCHSL__TraceDump(FILE*);
+
+static inline void trace(enum trace_event e, uint32_t conn, uint16_t arg) {
+    if (!PSCHSL__traceon) return;
+    struct trace_ring* r = PSCHSL__tracering;
+    if (!r && !(r = PSCHSL__TraceThreadStart())) return;
+    // only the owning thread writes, so a plain increment is enough; the release store lets dumps see whole records
+    uint64_t p = r->pos;
+    struct trace_rec* rec = &r->recs[p & (TRACE_RINGSIZE - 1)];
+    rec->time = altutime();
+    rec->conn = conn;
+    rec->event = e;
+    rec->arg = arg;
+    atomicstore(&r->pos, p + 1);
+}
+
+#endif
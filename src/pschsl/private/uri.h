@@ -0,0 +1,40 @@
+#ifndef PSCHSL_URI_H
+#define PSCHSL_URI_H
+
+#include "vlb.h"
+
+#include <stddef.h>
+#include <stdbool.h>
+
+struct uri_qparam {
+    char* name;
+    char* value;
+};
+// Query params kept in the struct before going to the heap
+#define URI_INLINEQPARAMS 8
+
+// Decoded request target
+//   - Must not be moved once decoded (the first query params are stored inline)
+struct uri {
+    char* path;      // Percent-decoded (and canonized if requested) path
+    size_t pathlen;
+    char* query;     // Raw query string without the '?', or NULL if there is none
+    size_t querylen;
+    bool qparsed;    // If the query params were split and decoded yet
+    struct VLB_SBO(struct uri_qparam, URI_INLINEQPARAMS) qparams;
+};
+enum uri_result {
+    URI_OK,
+    URI_BAD,
+    URI_TOOLONG
+};
+
+// Decodes a request target in place (s must have room for len + 1 chars)
+//   - Query params are left alone until PSCHSL__URIParseQuery is called
+enum uri_result PSCHSL__DecodeURI(struct uri*, char* s, size_t len, size_t maxlen, bool canon);
+// Splits and decodes the query params in place
+bool PSCHSL__URIParseQuery(struct uri*);
+const char* PSCHSL__URIGetQueryParam(struct uri*, const char* name);
+void PSCHSL__FreeURI(struct uri*);
+
+#endif
@@ -3,6 +3,7 @@
 
 #include <stddef.h>
 #include <stdlib.h>
+#include <string.h>
 
 #define VLB(T) {\
     T* data;\
@@ -70,4 +71,68 @@
     }\
 } while (0)
 
+// Variant with N elements of inline storage; only goes to the heap once it outgrows them
+//   - data points into the struct while inline, so the struct must not be moved or copied
+#define VLB_SBO(T, N) {\
+    T* data;\
+    size_t len;\
+    size_t size;\
+    T inl[N];\
+}
+
+#define VLB__SBORESIZE(VLB__b, VLB__sz, VLB__do, ...) do {\
+    void* VLB__ptr;\
+    if ((VLB__b).data == (VLB__b).inl) {\
+        VLB__ptr = malloc((VLB__sz) * sizeof(*(VLB__b).data));\
+        if (VLB__ptr) memcpy(VLB__ptr, (VLB__b).inl, (VLB__b).len * sizeof(*(VLB__b).data));\
+    } else {\
+        VLB__ptr = realloc((VLB__b).data, (VLB__sz) * sizeof(*(VLB__b).data));\
+    }\
+    if (VLB__ptr) {(VLB__b).data = VLB__ptr; (VLB__b).size = (VLB__sz); VLB__do;}\
+    else {__VA_ARGS__}\
+} while (0)
+#define VLB__SBOEXP(VLB__b, VLB__en, VLB__ed, VLB__do, ...) do {\
+    if ((VLB__b).len != (VLB__b).size) {\
+        VLB__do;\
+    } else {\
+        register size_t VLB__tmp = (VLB__b).size;\
+        VLB__tmp = VLB__tmp * (VLB__en) / (VLB__ed);\
+        if (VLB__tmp == (VLB__b).size) ++VLB__tmp;\
+        VLB__SBORESIZE((VLB__b), VLB__tmp, VLB__do, __VA_ARGS__);\
+    }\
+} while (0)
+
+#define VLB_SBO_INIT(VLB__b) do {\
+    (VLB__b).data = (VLB__b).inl;\
+    (VLB__b).len = 0;\
+    (VLB__b).size = sizeof((VLB__b).inl) / sizeof(*(VLB__b).inl);\
+} while (0)
+#define VLB_SBO_FREE(VLB__b) do {\
+    if ((VLB__b).data != (VLB__b).inl) free((VLB__b).data);\
+} while (0)
+
+#define VLB_SBO_ADD(VLB__b, VLB__d, VLB__en, VLB__ed, ...) do {\
+    VLB__SBOEXP((VLB__b), (VLB__en), (VLB__ed), (VLB__b).data[(VLB__b).len++] = (VLB__d), __VA_ARGS__);\
+} while (0)
+#define VLB_SBO_NEXTPTR(VLB__b, VLB__o, VLB__en, VLB__ed, ...) do {\
+    VLB__SBOEXP((VLB__b), (VLB__en), (VLB__ed), (VLB__o) = &(VLB__b).data[(VLB__b).len++], __VA_ARGS__);\
+} while (0)
+#define VLB_SBO_EXPANDTO(VLB__b, VLB__l, VLB__en, VLB__ed, ...) do {\
+    register size_t VLB__l2 = (VLB__l);\
+    if (VLB__l2 > (VLB__b).size) {\
+        register size_t VLB__tmp = (VLB__b).size;\
+        do {\
+            register size_t VLB__old = VLB__tmp;\
+            VLB__tmp = VLB__tmp * (VLB__en) / (VLB__ed);\
+            if (VLB__tmp == VLB__old) ++VLB__tmp;\
+        } while (VLB__tmp < VLB__l2);\
+        VLB__SBORESIZE((VLB__b), VLB__tmp, (VLB__b).len = VLB__l2, __VA_ARGS__);\
+    } else if (VLB__l2 > (VLB__b).len) {\
+        (VLB__b).len = VLB__l2;\
+    }\
+} while (0)
+#define VLB_SBO_EXPAND(VLB__b, VLB__a, VLB__en, VLB__ed, ...) do {\
+    VLB_SBO_EXPANDTO((VLB__b), (VLB__b).len + (VLB__a), (VLB__en), (VLB__ed), __VA_ARGS__);\
+} while (0)
+
 #endif
@@ -0,0 +1,117 @@
+#ifndef PSCHSL_WS_H
+#define PSCHSL_WS_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include <zlib-ng.h>
+
+#include "threading.h"
+#include "charbuf.h"
+
+// Length of a Sec-WebSocket-Accept value plus the NUL
+#define WS_ACCEPTSIZE 29
+#define WS_MAXFRAMEHDRLEN 14
+
+enum ws_opcode {
+    WS_OP_CONT = 0x0,
+    WS_OP_TEXT = 0x1,
+    WS_OP_BINARY = 0x2,
+    WS_OP_CLOSE = 0x8,
+    WS_OP_PING = 0x9,
+    WS_OP_PONG = 0xA
+};
+struct wsframe {
+    bool fin;
+    uint8_t rsv; // RSV1-3 as in the first header byte (0x40 is RSV1, set on permessage-deflate messages)
+    uint8_t opcode;
+    bool masked;
+    uint8_t mask[4];
+    uint64_t len;
+};
+enum ws_result {
+    WS_INCOMPLETE, // The message needs more frames
+    WS_MESSAGE,    // A whole text or binary message is in the buffer
+    WS_CONTROL,    // The frame was a control frame; handle it from the frame payload directly
+    WS_ERRPROTO,   // Close with 1002
+    WS_ERRDATA,    // Close with 1007 (invalid UTF-8)
+    WS_ERRTOOBIG   // Close with 1009
+};
+
+// Pool of message buffers so that reassembly does not allocate for every message
+//   - Buffers are handed out and taken back by value, so a pooled message costs no allocations
+struct wspool {
+    mutex_t lock;
+    struct charbuf* free;
+    size_t count;
+    size_t max;
+};
+// Negotiated permessage-deflate parameters (RFC 7692)
+struct wsdeflate_params {
+    bool servernoctx;   // server_no_context_takeover
+    bool clientnoctx;   // client_no_context_takeover
+    uint8_t serverbits; // server_max_window_bits (9-15)
+};
+// permessage-deflate state of one connection
+struct wsdeflate {
+    struct wsdeflate_params params;
+    zng_stream inf;
+    zng_stream def;
+};
+// Message reassembly state of one connection
+//   - Must not be moved once initialized (small messages are kept inline)
+struct wsasm {
+    struct sbcharbuf buf; // Inline for small messages, a pooled buffer once it outgrows that
+    bool active; // A message is in progress
+    uint8_t opcode;
+    bool compressed; // The first frame had RSV1 set
+    size_t max;
+    struct wsdeflate* deflate; // NULL if permessage-deflate was not negotiated
+};
+
+// Makes the Sec-WebSocket-Accept value for a Sec-WebSocket-Key
+void PSCHSL__WSAcceptKey(const char* key, char out[WS_ACCEPTSIZE]);
+// Parses a client frame header
+//   - allowrsv has the RSV bits the negotiated extensions allow (0x40 for permessage-deflate), in the same position as
+//     in the first header byte
+//   - Returns the header length, 0 if more data is needed, or -1 if the frame is invalid
+int PSCHSL__WSParseFrameHdr(const uint8_t* in, size_t len, uint8_t allowrsv, struct wsframe*);
+// Writes an unmasked server frame header; returns its length
+size_t PSCHSL__WSPutFrameHdr(uint8_t out[WS_MAXFRAMEHDRLEN], bool fin, enum ws_opcode, uint64_t len);
+// XORs data with the mask; off is the position of data within the frame payload
+void PSCHSL__WSUnmask(uint8_t* data, size_t len, const uint8_t mask[4], uint64_t off);
+bool PSCHSL__UTF8Valid(const uint8_t*, size_t);
+
+bool PSCHSL__WSPoolInit(struct wspool*, size_t max);
+void PSCHSL__WSPoolFree(struct wspool*);
+// Fills out with an empty buffer; returns false on failure
+bool PSCHSL__WSPoolGet(struct wspool*, struct charbuf* out);
+// Takes the buffer back (b must not be used afterwards)
+void PSCHSL__WSPoolPut(struct wspool*, struct charbuf* b);
+
+// Picks the first permessage-deflate offer in a Sec-WebSocket-Extensions header that can be accepted
+//   - On success, writes the Sec-WebSocket-Extensions response value to resp and returns true
+bool PSCHSL__WSNegotiateDeflate(const char* hdr, struct wsdeflate_params*, char* resp, size_t respsz);
+bool PSCHSL__WSDeflateInit(struct wsdeflate*, const struct wsdeflate_params*);
+void PSCHSL__WSDeflateFree(struct wsdeflate*);
+// Inflates a whole compressed message and appends it to out
+//   - Returns WS_MESSAGE on success, WS_ERRTOOBIG if out would grow past max, or WS_ERRDATA if the data is invalid
+enum ws_result PSCHSL__WSInflate(struct wsdeflate*, const uint8_t* in, size_t len, struct charbuf* out, size_t max);
+// Compresses a whole message and appends it to out, ready to be sent in frames with RSV1 set on the first one
+bool PSCHSL__WSDeflate(struct wsdeflate*, const void* in, size_t len, struct charbuf* out);
+
+static inline void wsasm_init(struct wsasm* a, size_t max, struct wsdeflate* deflate) {
+    sbcb_init(&a->buf);
+    a->active = false;
+    a->opcode = 0;
+    a->compressed = false;
+    a->max = max;
+    a->deflate = deflate;
+}
+// Adds an unmasked frame payload; on WS_MESSAGE the (inflated) message is in a->buf until PSCHSL__WSAsmDone is called
+enum ws_result PSCHSL__WSAsmFeed(struct wsasm*, struct wspool*, const struct wsframe*, const uint8_t* payload);
+void PSCHSL__WSAsmDone(struct wsasm*, struct wspool*);
+
+#endif
@@ -1,6 +1,11 @@
 #define PSCHSL_NOLEGACY
 #include "pschsl.h"
 
+#include "private/arena.h"
+#include "private/trace.h"
+
+#include <stdio.h>
+
 const unsigned (*PSCHSL_GetVersion(void))[3] {
     static const unsigned ver[3] = {
         PSCHSL_VER_MAJOR,
@@ -11,9 +16,22 @@ const unsigned (*PSCHSL_GetVersion(void))[3] {
 }
 
 struct PSCHSL_Ctx {
-    int placeholder;
+    struct arena mem;
 };
 
+void* PSCHSL_Ctx_Alloc(struct PSCHSL_Ctx* ctx, size_t sz) {
+    return arena_alloc(&ctx->mem, sz);
+}
+
 struct PSCHSL {
     int placeholder;
 };
+
+int PSCHSL_DumpTrace(struct PSCHSL* state, const char* path) {
+    (void)state;
+    FILE* f = fopen(path, "wb");
+    if (!f) return 0;
+    int ok = PSCHSL__TraceDump(f);
+    if (fclose(f)) ok = 0;
+    return ok;
+}
@@ -47,6 +47,21 @@ enum PSCHSL_Ctx_Opt {
                                        //   before checking if PSCHSL_Stop was called -- default is 1 sec
     PSCHSL_CTX_OPT_TIMEOUT,            // uint64_t us -- Amount of microseconds to wait for the client to send a valid
                                        //   request -- default is 15 sec
+    PSCHSL_CTX_OPT_CACHEABLE,          // int enabled -- Allow/disallow storing the response in the response cache of
+                                       //   the request method (see PSCHSL_OPT_RESPCACHE); only 200 responses are stored
+                                       //   -- default is enabled
+    PSCHSL_CTX_OPT_SENDQMAX,           // size_t sz -- Max amount of emitted response bytes to queue while the client is
+                                       //   not reading fast enough -- default is 1MiB
+    PSCHSL_CTX_OPT_SENDQBLOCK,         // int enabled -- If enabled, PutText and PutBytes wait, holding on to the
+                                       //   thread, until the send queue has drained to half of SENDQMAX once it is
+                                       //   full; if disabled, they fail without taking any data and
+                                       //   PSCHSL_Resp_WouldBlock returns non-zero, so a slow client never ties up a
+                                       //   thread -- default is disabled
+    PSCHSL_CTX_OPT_TCPNODELAY,         // int enabled -- Enable/disable TCP_NODELAY on the connection -- default is
+                                       //   enabled
+    PSCHSL_CTX_OPT_AUTOCORK,           // int enabled -- If enabled, hold back partial TCP segments (TCP_CORK/MSG_MORE)
+                                       //   while a response is written in several parts and push everything out once
+                                       //   it is complete or a PutText/PutBytes call has to wait -- default is enabled
 };
 enum PSCHSL_Ctx_Opt_Comp {
     PSCHSL_CTX_OPT_COMP_NONE,
@@ -66,6 +81,14 @@ int PSCHSL_Ctx_SetOpt(struct PSCHSL_Ctx*, enum PSCHSL_Ctx_Opt, ...);
 
 // Get the PSCHSL state the given context is associated with
 struct PSCHSL* PSCHSL_Ctx_GetState(struct PSCHSL_Ctx*);
+// Get the HTTP version of the request the context is handling
+//   - Returns 10 for HTTP/1.0, 11 for HTTP/1.1, or 20 for HTTP/2
+int PSCHSL_Ctx_GetHTTPVer(struct PSCHSL_Ctx*);
+
+// Allocate temporary memory tied to the current request
+//   - The memory is released in bulk once the request is finished and must not be freed
+//   - On success, returns a pointer to at least sz bytes that is valid until the callback returns, or NULL on failure
+void* PSCHSL_Ctx_Alloc(struct PSCHSL_Ctx*, size_t sz);
 
 //// ------------------- ////
 //// ----- REQUEST ----- ////
@@ -99,6 +122,7 @@ const char* PSCHSL_Rqst_GetQueryParamByIndex(struct PSCHSL_Ctx*, size_t i);
 //   - On success, returns a string that is valid until the callback returns, or NULL on failure
 const char* PSCHSL_Rqst_GetHeader(struct PSCHSL_Ctx*, const char* name);
 // Return the number of headers
+//   - If name is not NULL, only count the headers with that name
 size_t PSCHSL_Rqst_GetHeaderCount(struct PSCHSL_Ctx*, const char* name);
 // Get the name of a header by index
 //   - On success, returns a string that is valid until the callback returns, or NULL on failure
@@ -130,26 +154,151 @@ int PSCHSL_Resp_SetHeader(struct PSCHSL_Ctx*, const char* name, const char* valu
 void PSCHSL_Resp_DelHeader(struct PSCHSL_Ctx*, const char* name);
 
 // Write text response content
-//   - Returns non-zero for success, zero for failure
+//   - Returns non-zero for success, zero for failure (including a full send queue, see PSCHSL_Resp_WouldBlock)
 int PSCHSL_Resp_PutText(struct PSCHSL_Ctx*, const char* text);
 // Write binary response content
-//   - Returns non-zero for success, zero for failure
+//   - Returns non-zero for success, zero for failure (including a full send queue, see PSCHSL_Resp_WouldBlock)
 int PSCHSL_Resp_PutBytes(struct PSCHSL_Ctx*, size_t sz, void* data);
+// Check if the send queue is full (see PSCHSL_CTX_OPT_SENDQMAX)
+//   - Returns non-zero if PutText or PutBytes would have to wait or fail, zero otherwise
+int PSCHSL_Resp_WouldBlock(struct PSCHSL_Ctx*);
+
+// Set the validators of the response and check the request's conditional headers against them
+//   - etag is a complete entity tag (e.g. "\"abc\"" or "W/\"abc\""), or NULL if there is none
+//   - lastmod is the modification time as a Unix timestamp, or -1 if there is none
+//   - Sets the ETag and Last-Modified headers
+//   - If PSCHSL_CTX_OPT_OPTIPATH is enabled, it must be called first and takes the place of the one SetStatus call (the
+//     status is set to 200 if the conditions pass)
+//   - Returns zero if the status was set to 304 "Not Modified" or 412 "Precondition Failed" and no content should be
+//     written, non-zero otherwise
+int PSCHSL_Resp_SetValidators(struct PSCHSL_Ctx*, const char* etag, long long lastmod);
+// Write the contents of a file as the response content
+//   - Uses the file's size and modification time as validators (see SetValidators) and honors single-range Range and
+//     If-Range requests, so only the requested part of the file is read and sent
+//   - Sets the status (200, 206, 304, 412 or 416) and the Content-Length, ETag, Last-Modified and Accept-Ranges headers
+//     (and Content-Range for 206 and 416), replacing any status that was set before
+//   - If PSCHSL_CTX_OPT_OPTIPATH is enabled, it must be called first and takes the place of the one SetStatus call
+//   - If PSCHSL_CTX_OPT_IMMEMIT is enabled, the response is emitted once the content starts being written, so other
+//     headers must be set before the call; with OPTIPATH also enabled, no other headers can be added
+//   - If it fails before anything was emitted, the status and headers are left as they were; if it fails while writing
+//     the content, the response cannot be completed and the callback should return PSCHSL_CTX_CBSTATUS_ABORT
+//   - Returns non-zero for success, zero for failure
+int PSCHSL_Resp_PutFile(struct PSCHSL_Ctx*, const char* path);
+
+//// --------------------- ////
+//// ----- WEBSOCKET ----- ////
+//// --------------------- ////
+
+struct PSCHSL_WS;
+enum PSCHSL_WS_MsgType {
+    PSCHSL_WS_MSGTYPE_TEXT,
+    PSCHSL_WS_MSGTYPE_BINARY
+};
+struct PSCHSL_WS_Callbacks {
+    // Called once the 101 response was sent (can be NULL)
+    void (*open)(struct PSCHSL_WS*, void* userdata);
+    // Called for every complete message; fragmented messages are reassembled first and text messages are checked to
+    //   be valid UTF-8
+    //   - data is valid until the callback returns
+    //   - Return zero to close the connection, non-zero otherwise
+    int (*message)(struct PSCHSL_WS*, enum PSCHSL_WS_MsgType, size_t sz, const void* data, void* userdata);
+    // Called once when the connection is closed (can be NULL)
+    //   - code is the close code sent by the peer or the server, or 1006 if the connection was lost
+    void (*close)(struct PSCHSL_WS*, int code, void* userdata);
+};
+
+// Upgrade the connection to a WebSocket once the callback returns
+//   - Must be called from a PSCHSL_Ctx_Callback handling a valid WebSocket handshake request
+//   - Sets the status to 101 "Switching Protocols" and the Upgrade, Connection and Sec-WebSocket-Accept headers (and
+//     Sec-WebSocket-Extensions if permessage-deflate was accepted, see PSCHSL_OPT_WSDEFLATE); any content written is
+//     discarded
+//   - The callback must return PSCHSL_CTX_CBSTATUS_OK; the connection is then served by the event loop instead of the
+//     thread pool and the callbacks in cb (which is copied) are run from there
+//   - Not available for HTTP/2 requests
+//   - Returns non-zero for success, zero for failure (e.g. if the request is not a WebSocket handshake)
+int PSCHSL_Ctx_UpgradeWS(struct PSCHSL_Ctx*, const struct PSCHSL_WS_Callbacks* cb, void* userdata);
+
+// Get the PSCHSL state the given WebSocket is associated with
+struct PSCHSL* PSCHSL_WS_GetState(struct PSCHSL_WS*);
+// Send a message
+//   - The message is compressed if permessage-deflate was accepted for the connection
+//   - Can be called from any thread
+//   - Returns non-zero for success, zero for failure
+int PSCHSL_WS_Send(struct PSCHSL_WS*, enum PSCHSL_WS_MsgType, size_t sz, const void* data);
+// Start closing the connection
+//   - code is the close code to send (e.g. 1000), and reason is a string (can be NULL) of at most 123 bytes
+//   - Can be called from any thread
+void PSCHSL_WS_Close(struct PSCHSL_WS*, int code, const char* reason);
+
+//// --------------------- ////
+//// ----- STREAMING ----- ////
+//// --------------------- ////
+
+struct PSCHSL_Park;
+struct PSCHSL_ParkGroup;
+typedef void (*PSCHSL_Park_CloseCallback)(struct PSCHSL_Park*, void* userdata);
+
+// Park the connection once the callback returns so that its response can be continued from any thread later (e.g. for
+//   Server-Sent Events or long-polling)
+//   - Must be called from a PSCHSL_Ctx_Callback, which must then return PSCHSL_CTX_CBSTATUS_OK
+//   - The status, headers and any content written are sent right after the callback returns; Content-Length is not
+//     sent and HTTP/1.1 responses use chunked transfer encoding
+//   - The connection is then served by the event loop instead of the thread pool
+//   - cb (can be NULL) is called from the event loop if the connection is lost or falls behind by more than
+//     PSCHSL_OPT_PARKMAXPEND bytes
+//   - On success, returns a handle that stays valid until PSCHSL_Park_Release is called, or NULL on failure
+struct PSCHSL_Park* PSCHSL_Ctx_Park(struct PSCHSL_Ctx*, PSCHSL_Park_CloseCallback cb, void* userdata);
+// Queue more response content on a parked connection
+//   - Can be called from any thread; does not wait for the data to be sent
+//   - Returns non-zero for success, zero for failure (e.g. if the connection was lost or ended)
+int PSCHSL_Park_Push(struct PSCHSL_Park*, size_t sz, const void* data);
+// End the response once everything queued before was sent
+//   - Can be called from any thread
+//   - The connection is kept open for more requests if possible
+void PSCHSL_Park_End(struct PSCHSL_Park*);
+// Release a parked connection handle
+//   - Ends the response if PSCHSL_Park_End was not called yet
+void PSCHSL_Park_Release(struct PSCHSL_Park*);
+
+// Create a group of parked connections
+//   - Returns NULL on failure
+struct PSCHSL_ParkGroup* PSCHSL_ParkGroup_Create(struct PSCHSL*);
+// Destroy a group of parked connections
+//   - The connections themselves are not ended
+void PSCHSL_ParkGroup_Destroy(struct PSCHSL_ParkGroup*);
+// Add a parked connection to a group
+//   - The group holds on to the connection on its own, so the handle can be released while it is in the group
+//   - Connections that were lost or ended are removed from the group automatically
+//   - Returns non-zero for success, zero for failure
+int PSCHSL_ParkGroup_Add(struct PSCHSL_ParkGroup*, struct PSCHSL_Park*);
+// Remove a parked connection from a group
+void PSCHSL_ParkGroup_Del(struct PSCHSL_ParkGroup*, struct PSCHSL_Park*);
+// Queue the same response content on every connection in a group
+//   - The data is copied once and shared by all the connections instead of being copied for each one
+//   - Can be called from any thread
+//   - Returns the amount of connections the data was queued on
+size_t PSCHSL_ParkGroup_Broadcast(struct PSCHSL_ParkGroup*, size_t sz, const void* data);
 
 //// ---------------------- ////
 //// ----- MAIN STATE ----- ////
 //// ---------------------- ////
 
 struct PSCHSL;
+enum PSCHSL_Prio {
+    PSCHSL_PRIO_HIGH,   // For health checks, control endpoints, etc.
+    PSCHSL_PRIO_NORMAL,
+    PSCHSL_PRIO_LOW     // For bulk uploads, reports, etc.
+};
 enum PSCHSL_Opt {
-    PSCHSL_OPT_BINDADDR,        // char* addr -- Address to bind to -- default is 0.0.0.0
-    PSCHSL_OPT_BINDPORT,        // unsigned port -- Port to bind to -- default is 8080
+    PSCHSL_OPT_BINDADDR,        // char* addr -- Address to bind to if no listeners were added -- default is 0.0.0.0
+    PSCHSL_OPT_BINDPORT,        // unsigned port -- Port to bind to if no listeners were added -- default is 8080
     PSCHSL_OPT_DEFAULTCTXOPT,   // enum PSCHSL_Ctx_Opt ctxopt, ... -- Set default options for I/O contexts
     PSCHSL_OPT_DEFAULTRQSTMOPT, // char* method, enum PSCHSL_Ctx_Opt ctxopt, ... -- Set default options for a request
                                 //   method
     PSCHSL_OPT_MAXURILEN,       // size_t maxlen -- Any request target or URI longer than this will result in error 414
                                 //   -- default is 64KiB
-    PSCHSL_OPT_CANONURI,        // int enabled -- Enable/disable resolving . and .. in URIs
+    PSCHSL_OPT_CANONURI,        // int enabled -- Enable/disable resolving . and .. in URIs (percent-encoded slashes
+                                //   are treated as separators when this is enabled)
     PSCHSL_OPT_MAXRQSTHDRLEN,   // size_t maxlen -- Any headers longer than this will result in error 431 -- default is
                                 //   SIZE_MAX
     PSCHSL_OPT_MAXRQSTHDRMEM,   // size_t maxlen -- Max amount of memory to allocate for storing headers; going over
@@ -164,9 +313,93 @@ enum PSCHSL_Opt {
     PSCHSL_OPT_CHKSTOPAFTERSEL, // int enabled -- Enable/disable checking if PSCHSL_Stop was called after waiting on a
                                 //   new connection (if so and a new connection was made, immediately close it and exit)
                                 //   -- default is disabled
-    PSCHSL_OPT_CBONERROR        // int enabled -- Enable/disable calling the request handler to set headers and content
+    PSCHSL_OPT_CBONERROR,       // int enabled -- Enable/disable calling the request handler to set headers and content
                                 //   on errors; the default status will be set to a code appropriate for the error that
                                 //   was encountered instead of the usual 200 "OK" -- default is enabled
+    PSCHSL_OPT_DRAINTIME,       // uint64_t us -- Once PSCHSL_Stop is called, stop accepting new connections but let
+                                //   in-flight and keep-alive requests finish for up to the given amount of microseconds
+                                //   before closing everything -- default is 0
+    PSCHSL_OPT_LAZYRQSTHDRS,    // int enabled -- If enabled, only record where headers are while parsing and copy a
+                                //   header the first time it is requested; only copied headers count towards
+                                //   MAXRQSTHDRMEM, and going over makes the getter return NULL instead of causing error
+                                //   431 -- default is disabled
+    PSCHSL_OPT_LOOPCPUS,        // size_t count, const unsigned* cpus -- Pin the thread running PSCHSL_Run or
+                                //   PSCHSL_Step to the given CPUs, or unpin if count is 0 -- default is unpinned
+    PSCHSL_OPT_THREADPOOL_CPUS, // size_t count, const unsigned* cpus -- Pin each thread pool thread to one of the given
+                                //   CPUs (in order, wrapping around); threads are pinned before they allocate anything,
+                                //   so their buffers, arenas and connections are placed on that CPU's NUMA node --
+                                //   default is unpinned
+    PSCHSL_OPT_CPUSTEER,        // int enabled -- If enabled and THREADPOOL_CPUS is set, hand new connections to a
+                                //   thread pinned to the CPU that received their packets when one is free (Linux only)
+                                //   -- default is disabled
+    PSCHSL_OPT_H2C,             // int enabled -- Enable/disable cleartext HTTP/2, both with prior knowledge and through
+                                //   "Upgrade: h2c"; each stream gets its own I/O context and goes through the same
+                                //   method handlers, and PutText/PutBytes wait for flow control window when needed --
+                                //   default is disabled
+    PSCHSL_OPT_H2MAXSTREAMS,    // unsigned max -- Max amount of concurrent HTTP/2 streams per connection -- default is
+                                //   100
+    PSCHSL_OPT_H2WINDOW,        // unsigned sz -- Initial HTTP/2 flow control window size to advertise for each stream
+                                //   -- default is 65535
+    PSCHSL_OPT_RESPCACHE,       // char* method, uint64_t ttl, size_t maxmem, const char* const* varyhdrs -- Cache whole
+                                //   responses for a request method for ttl microseconds, keyed on the method, the raw
+                                //   target with query, and the values of the request headers in the NULL-terminated
+                                //   varyhdrs list (can be NULL); a cached response is sent as-is (compressed if it was)
+                                //   without calling the handler, and the least recently used responses are dropped once
+                                //   maxmem is reached; responses are stored separately for HTTP/1.0 and HTTP/1.1 and
+                                //   for keep-alive and closing connections, and HTTP/2 responses are not cached; maxmem
+                                //   is split into 16 shards, so responses bigger than maxmem / 16 are never cached; a
+                                //   ttl of 0 disables the cache for the method -- default is disabled
+    PSCHSL_OPT_MAXCONNS,        // unsigned max -- Max amount of open connections; new connections past this are sent a
+                                //   503 and closed without reading the request, or 0 for no limit -- default is 0
+    PSCHSL_OPT_MAXINFLIGHT,     // unsigned max -- Max amount of requests being handled at once; requests past this are
+                                //   sent a 503 without parsing them or calling the handler, or 0 for no limit --
+                                //   default is 0
+    PSCHSL_OPT_MAXQUEUEDELAY,   // uint64_t us -- Send a 503 instead of handling a request that waited for a thread for
+                                //   longer than this, or 0 for no limit -- default is 0
+    PSCHSL_OPT_RETRYAFTER,      // unsigned secs -- Value of the Retry-After header sent with 503s from the above limits
+                                //   -- default is 1
+    PSCHSL_OPT_ACCEPTPAUSE,     // uint64_t us -- Amount of microseconds to stop accepting connections for when out of
+                                //   file descriptors or memory -- default is 100 msec
+    PSCHSL_OPT_TRACE,           // int enabled -- Enable/disable recording request events (accept, headers parsed,
+                                //   callback start and end, first byte sent, close) into a per-thread ring buffer for
+                                //   PSCHSL_DumpTrace -- default is enabled
+    PSCHSL_OPT_TCPDEFERACCEPT,  // unsigned secs -- Only wake up for new TCP connections once they sent data or the
+                                //   given amount of seconds passed, or 0 to disable (Linux only) -- default is 0
+    PSCHSL_OPT_TCPFASTOPEN,     // unsigned qlen -- Max amount of pending TCP Fast Open requests, or 0 to disable --
+                                //   default is 0
+    PSCHSL_OPT_ACCEPTBATCH,     // unsigned max -- Max amount of connections to accept at once when woken up -- default
+                                //   is 16
+    PSCHSL_OPT_SOCKBUSYPOLL,    // unsigned us -- Amount of microseconds to busy-poll the device queue for when reading
+                                //   from a connection, or 0 to disable (Linux only) -- default is 0
+    PSCHSL_OPT_SOCKSNDBUF,      // int sz -- Socket send buffer size, or 0 for the system default -- default is 0
+    PSCHSL_OPT_SOCKRCVBUF,      // int sz -- Socket receive buffer size, or 0 for the system default -- default is 0
+    PSCHSL_OPT_LOWLATENCY,      // int enabled -- If enabled, set the above to a profile suited for low-latency
+                                //   deployments (TCPDEFERACCEPT 1, TCPFASTOPEN 256, ACCEPTBATCH 64, SOCKBUSYPOLL 50)
+                                //   and enable TCPNODELAY and AUTOCORK in the default I/O context options; if disabled,
+                                //   reset them to their defaults -- default is disabled
+    PSCHSL_OPT_WSMAXMSG,        // size_t sz -- Max size of a reassembled WebSocket message; larger messages close the
+                                //   connection with 1009 -- default is 16MiB
+    PSCHSL_OPT_WSDEFLATE,       // int enabled -- Accept the permessage-deflate WebSocket extension if the client offers
+                                //   it (uses zlib-ng) -- default is disabled
+    PSCHSL_OPT_PARKMAXPEND,     // size_t sz -- Max amount of bytes that can wait to be sent on a parked connection
+                                //   before it is closed, or 0 for unlimited -- default is 1MiB
+    PSCHSL_OPT_RATELIMIT,       // char* method, unsigned rate, unsigned burst, char* keyhdr -- Limit each client to
+                                //   rate requests per second for a request method (NULL for the fallback handler),
+                                //   allowing bursts of up to burst requests (max 65535); clients are told apart by the
+                                //   value of the keyhdr header (e.g. "X-Forwarded-For"), or by IP address if keyhdr is
+                                //   NULL; requests over the limit get error 429 with a Retry-After header without
+                                //   running the callback; a rate of 0 removes the limit -- default is no limit
+    PSCHSL_OPT_RATELIMITSLOTS,  // size_t count -- Amount of clients each rate limit tracks at once; once full, clients
+                                //   that are not tracked are not limited -- default is 65536
+    PSCHSL_OPT_METHODPRIO,      // char* method, enum PSCHSL_Prio prio -- Set the priority class of the handler of a
+                                //   request method (NULL for the fallback handler); when requests have to wait for a
+                                //   thread, higher classes are served first -- default is PSCHSL_PRIO_NORMAL
+    PSCHSL_OPT_PRIORESERVE      // enum PSCHSL_Prio prio, unsigned count -- Keep count of the THREADPOOL_MIN threads
+                                //   free for requests of a priority class, so that they never wait behind other
+                                //   classes; fails if the reservations together would not leave at least one thread; if
+                                //   THREADPOOL_MIN is lowered later, the reservations of the lowest classes are cut
+                                //   down until one thread is left, and restored if it is raised again -- default is 0
+                                //   for every class
 };
 
 // Creates a PSCHSL state
@@ -183,11 +416,46 @@ int PSCHSL_Step(struct PSCHSL*);
 void PSCHSL_Stop(struct PSCHSL*);
 // Checks is PSCHSL_Stop was called
 int PSCHSL_IsStopRqstd(struct PSCHSL*);
+// Checks if the state is still finishing requests after PSCHSL_Stop was called (see PSCHSL_OPT_DRAINTIME)
+int PSCHSL_IsDraining(struct PSCHSL*);
+
+// Add a TCP listener
+//   - If no listeners are added, a single TCP listener is made from BINDADDR and BINDPORT
+//   - addr can be an IPv4 or IPv6 address, or NULL to listen on all addresses
+//   - Returns non-zero for success, zero for failure
+int PSCHSL_AddTCPListener(struct PSCHSL*, const char* addr, unsigned port);
+// Add a Unix domain socket listener
+//   - If path starts with '@', the rest of it is used as an abstract socket name (Linux only)
+//   - An existing socket file at path is replaced if nothing is listening on it anymore; if something still is, this
+//     fails
+//   - perms sets the permissions of the socket file (e.g. 0660), or -1 to leave them as the umask made them
+//   - Not available on Windows
+//   - Returns non-zero for success, zero for failure
+int PSCHSL_AddUnixListener(struct PSCHSL*, const char* path, int perms);
+
+// Sends the listening sockets to another process over a connected Unix domain socket using SCM_RIGHTS
+//   - Binds the listening sockets first if they were not bound yet
+//   - The sockets stay open and keep being served by this state; call PSCHSL_Stop afterwards to hand over
+//   - Not available on Windows
+//   - Returns non-zero for success, zero for failure
+int PSCHSL_ExportListeners(struct PSCHSL*, int unixsock);
+// Receives listening sockets sent with PSCHSL_ExportListeners and uses them instead of binding new ones
+//   - Must be called before PSCHSL_Run or the first PSCHSL_Step
+//   - BINDADDR, BINDPORT and any added listeners are ignored if this succeeds
+//   - Not available on Windows
+//   - Returns non-zero for success, zero for failure
+int PSCHSL_ImportListeners(struct PSCHSL*, int unixsock);
 
 // Sets an option
 //   - Returns non-zero for success, zero for failure
 int PSCHSL_SetOpt(struct PSCHSL*, enum PSCHSL_Opt, ...);
 
+// Write a snapshot of the most recent request events of every thread to a file (see PSCHSL_OPT_TRACE)
+//   - Does not pause request handling
+//   - Use tools/trace2json.c to convert the file to Chrome trace JSON
+//   - Returns non-zero for success, zero for failure
+int PSCHSL_DumpTrace(struct PSCHSL*, const char* path);
+
 // Bind a handler callback to a request method
 //   - If method is NULL, set the fallback callback (for this callback, the status will be set to 501 "Not implemented"
 //     by default)
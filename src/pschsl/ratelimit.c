@@ -0,0 +1,145 @@
+#include "private/ratelimit.h"
+#include "private/crc.h"
+#include "private/atomic.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+// Slots to look at before giving up on finding a place for a key
+#define PROBE 8
+// Marks a slot that is being evicted
+#define TOMBSTONE UINT64_MAX
+#define TOKBITS 24
+#define TOKMASK ((UINT64_C(1) << TOKBITS) - 1)
+
+static inline uint64_t mkstate(uint64_t t, uint64_t tok) {
+    return (t << TOKBITS) | tok;
+}
+
+// Returns the tokens the bucket has at time t (ms + 1)
+static inline uint64_t refill(struct ratelimit* r, uint64_t s, uint64_t t) {
+    uint64_t max = (uint64_t)r->burst << 8;
+    // a fresh slot (state 0) starts out full; times are stored plus one so that a used slot is never 0
+    if (!s) return max;
+    uint64_t st = s >> TOKBITS;
+    uint64_t tok = s & TOKMASK;
+    if (t <= st) return tok;
+    uint64_t el = t - st;
+    if (el >= (max * 1000) / ((uint64_t)r->rate << 8) + 1) return max;
+    tok += el * ((uint64_t)r->rate << 8) / 1000;
+    return (tok > max) ? max : tok;
+}
+
+bool PSCHSL__RateLimitInit(struct ratelimit* r, uint32_t rate, uint32_t burst, size_t slots, uint64_t now) {
+    if (!rate) return false;
+    if (!burst) burst = 1;
+    else if (burst > RATELIMIT_MAXBURST) burst = RATELIMIT_MAXBURST;
+    r->rate = rate;
+    r->burst = burst;
+    r->epoch = now;
+    r->seed = now ^ (uintptr_t)r;
+    r->shardslots = (slots + RATELIMIT_SHARDS - 1) / RATELIMIT_SHARDS;
+    if (r->shardslots < PROBE) r->shardslots = PROBE;
+    for (int i = 0; i < RATELIMIT_SHARDS; ++i) {
+        r->shards[i].slots = calloc(r->shardslots, sizeof(*r->shards[i].slots));
+        r->shards[i].sweeppos = 0;
+        if (!r->shards[i].slots) {
+            while (i--) free(r->shards[i].slots);
+            return false;
+        }
+    }
+    return true;
+}
+
+void PSCHSL__RateLimitFree(struct ratelimit* r) {
+    for (int i = 0; i < RATELIMIT_SHARDS; ++i) free(r->shards[i].slots);
+}
+
+static inline uint64_t mstime(struct ratelimit* r, uint64_t now) {
+    return ((now > r->epoch) ? (now - r->epoch) / 1000 : 0) + 1;
+}
+
+static struct rlslot* find(struct ratelimit* r, uint64_t h, uint64_t t) {
+    struct rlshard* sh = &r->shards[h >> 60];
+    size_t start = (h % r->shardslots);
+    // first pass: the key or a free slot
+    for (size_t i = 0; i < PROBE; ++i) {
+        struct rlslot* s = &sh->slots[(start + i) % r->shardslots];
+        uint64_t k = atomicload(&s->key);
+        if (k == h) return s;
+        if (!k) {
+            if (atomiccas(&s->key, k, h) || k == h) return s;
+        }
+    }
+    // second pass: take over a stale slot in the window
+    uint64_t max = (uint64_t)r->burst << 8;
+    for (size_t i = 0; i < PROBE; ++i) {
+        struct rlslot* s = &sh->slots[(start + i) % r->shardslots];
+        uint64_t st = atomicload(&s->state);
+        if (st == TOMBSTONE || refill(r, st, t) < max) continue;
+        uint64_t k = atomicload(&s->key);
+        if (!k || k == h) return s;
+        if (atomiccas(&s->key, k, h)) {
+            // whoever still uses the old key gets a fresh bucket, which it was due anyway
+            atomicstore(&s->state, 0);
+            return s;
+        }
+    }
+    return NULL;
+}
+
+unsigned PSCHSL__RateLimitTake(struct ratelimit* r, const void* key, size_t keylen, uint64_t now) {
+    uint64_t h = PSCHSL__ccrc64(r->seed, key, keylen);
+    if (!h || h == TOMBSTONE) h = 1;
+    uint64_t t = mstime(r, now);
+    for (int tries = 0; tries < 4; ++tries) {
+        struct rlslot* s = find(r, h, t);
+        if (!s) return 0;
+        uint64_t st = atomicload(&s->state);
+        while (1) {
+            if (st == TOMBSTONE) break;
+            uint64_t tok = refill(r, st, t);
+            if (tok < 256) {
+                uint64_t ms = ((256 - tok) * 1000 + ((uint64_t)r->rate << 8) - 1) / ((uint64_t)r->rate << 8);
+                return (ms + 999) / 1000;
+            }
+            // keep the newer time if another thread got a later timestamp in first
+            uint64_t nt = ((st >> TOKBITS) > t) ? (st >> TOKBITS) : t;
+            if (atomiccas(&s->state, st, mkstate(nt, tok - 256))) {
+                return 0;
+            }
+        }
+    }
+    // the slot kept getting evicted from under us
+    return 0;
+}
+
+void PSCHSL__RateLimitSweep(struct ratelimit* r, size_t max, uint64_t now) {
+    uint64_t t = mstime(r, now);
+    uint64_t full = (uint64_t)r->burst << 8;
+    if (max > r->shardslots) max = r->shardslots;
+    for (int i = 0; i < RATELIMIT_SHARDS; ++i) {
+        struct rlshard* sh = &r->shards[i];
+        size_t pos = atomicfetchadd(&sh->sweeppos, max);
+        for (size_t j = 0; j < max; ++j) {
+            struct rlslot* s = &sh->slots[(pos + j) % r->shardslots];
+            if (!atomicload(&s->key)) continue;
+            uint64_t st = atomicload(&s->state);
+            if (st == TOMBSTONE || refill(r, st, t) < full) continue;
+            // a full bucket holds no information, so dropping it changes nothing for the client
+            if (!atomiccas(&s->state, st, TOMBSTONE)) continue;
+            atomicstore(&s->key, 0);
+            atomicstore(&s->state, 0);
+        }
+    }
+}
+
+size_t PSCHSL__RateLimitResp(char* out, size_t outsz, unsigned retryafter) {
+    int l = snprintf(
+        out, outsz,
+        "HTTP/1.1 429 Too Many Requests\r\nRetry-After: %u\r\nContent-Length: 0\r\n\r\n",
+        retryafter
+    );
+    if (l < 0 || (size_t)l >= outsz) return 0;
+    return l;
+}
@@ -0,0 +1,108 @@
+#include "private/sched.h"
+
+bool PSCHSL__SchedInit(struct sched* s, unsigned threads) {
+    if (!createMutex(&s->lock)) return false;
+    for (int i = 0; i < SCHED_CLASSES; ++i) {
+        s->classes[i].head = NULL;
+        s->classes[i].tail = NULL;
+        s->classes[i].queued = 0;
+        s->classes[i].running = 0;
+        s->classes[i].wanted = 0;
+        s->classes[i].reserved = 0;
+    }
+    s->threads = threads;
+    s->running = 0;
+    s->queued = 0;
+    return true;
+}
+
+void PSCHSL__SchedFree(struct sched* s) {
+    destroyMutex(&s->lock);
+}
+
+// Hands out the wanted reservations in class order while leaving at least one thread unreserved
+static void fitreserve(struct sched* s) {
+    unsigned left = (s->threads) ? s->threads - 1 : 0;
+    for (unsigned i = 0; i < SCHED_CLASSES; ++i) {
+        unsigned r = s->classes[i].wanted;
+        if (r > left) r = left;
+        s->classes[i].reserved = r;
+        left -= r;
+    }
+}
+
+void PSCHSL__SchedSetThreads(struct sched* s, unsigned threads) {
+    lockMutex(&s->lock);
+    s->threads = threads;
+    fitreserve(s);
+    unlockMutex(&s->lock);
+}
+
+bool PSCHSL__SchedSetReserve(struct sched* s, unsigned prio, unsigned count) {
+    if (prio >= SCHED_CLASSES) return false;
+    lockMutex(&s->lock);
+    unsigned total = count;
+    for (unsigned i = 0; i < SCHED_CLASSES; ++i) {
+        if (i != prio) total += s->classes[i].wanted;
+    }
+    bool ok = (total < s->threads);
+    if (ok) {
+        s->classes[prio].wanted = count;
+        fitreserve(s);
+    }
+    unlockMutex(&s->lock);
+    return ok;
+}
+
+void PSCHSL__SchedPut(struct sched* s, struct schedjob* j) {
+    if (j->prio >= SCHED_CLASSES) j->prio = SCHED_CLASSES - 1;
+    j->next = NULL;
+    lockMutex(&s->lock);
+    if (s->classes[j->prio].tail) s->classes[j->prio].tail->next = j;
+    else s->classes[j->prio].head = j;
+    s->classes[j->prio].tail = j;
+    ++s->classes[j->prio].queued;
+    ++s->queued;
+    unlockMutex(&s->lock);
+}
+
+// Threads that have to stay free for the reservations of the classes other than c
+static inline unsigned held(struct sched* s, unsigned c) {
+    unsigned h = 0;
+    for (unsigned i = 0; i < SCHED_CLASSES; ++i) {
+        if (i != c && s->classes[i].running < s->classes[i].reserved) {
+            h += s->classes[i].reserved - s->classes[i].running;
+        }
+    }
+    return h;
+}
+
+struct schedjob* PSCHSL__SchedTake(struct sched* s) {
+    lockMutex(&s->lock);
+    struct schedjob* j = NULL;
+    if (!s->queued) goto ret;
+    for (unsigned c = 0; c < SCHED_CLASSES; ++c) {
+        if (!(j = s->classes[c].head)) continue;
+        // a class within its reservation can always start
+        if (s->classes[c].running >= s->classes[c].reserved && s->running + held(s, c) >= s->threads) {
+            j = NULL;
+            continue;
+        }
+        if (!(s->classes[c].head = j->next)) s->classes[c].tail = NULL;
+        --s->classes[c].queued;
+        --s->queued;
+        ++s->classes[c].running;
+        ++s->running;
+        break;
+    }
+    ret:;
+    unlockMutex(&s->lock);
+    return j;
+}
+
+void PSCHSL__SchedDone(struct sched* s, struct schedjob* j) {
+    lockMutex(&s->lock);
+    --s->classes[j->prio].running;
+    --s->running;
+    unlockMutex(&s->lock);
+}
@@ -0,0 +1,161 @@
+#include "private/sendq.h"
+
+#ifndef _WIN32
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <poll.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+
+#ifndef MSG_NOSIGNAL
+    #define MSG_NOSIGNAL 0
+#endif
+#ifndef MSG_MORE
+    #define MSG_MORE 0
+#endif
+
+// Max amount of chunks to hand to the kernel at once
+#define FLUSHIOVS 32
+// Smallest chunk to allocate so that many small writes do not each get their own chunk
+#define MINCHUNK 4096
+
+static inline enum sendq_result state(struct sendq* q) {
+    if (!q->queued) return SENDQ_DONE;
+    return (q->queued < q->highwm) ? SENDQ_PENDING : SENDQ_FULL;
+}
+
+static bool enqueue(struct sendq* q, const char* d, size_t l) {
+    if (!l) return true;
+    struct sendq_chunk* t = q->tail;
+    // fill up the slack in the last chunk first
+    if (t && t->cap > t->len) {
+        size_t n = t->cap - t->len;
+        if (n > l) n = l;
+        memcpy(t->data + t->len, d, n);
+        t->len += n;
+        q->queued += n;
+        d += n;
+        l -= n;
+        if (!l) return true;
+    }
+    size_t csz = (l > MINCHUNK) ? l : MINCHUNK;
+    struct sendq_chunk* c = malloc(sizeof(*c) + csz);
+    if (!c) return false;
+    c->next = NULL;
+    c->cap = csz;
+    c->len = l;
+    c->off = 0;
+    memcpy(c->data, d, l);
+    if (t) t->next = c;
+    else q->head = c;
+    q->tail = c;
+    q->queued += l;
+    return true;
+}
+
+void PSCHSL__SendqInit(struct sendq* q, size_t highwm) {
+    q->head = NULL;
+    q->tail = NULL;
+    q->queued = 0;
+    q->more = false;
+    q->highwm = highwm;
+    q->lowwm = highwm / 2;
+}
+
+void PSCHSL__SendqFree(struct sendq* q) {
+    struct sendq_chunk* c = q->head;
+    while (c) {
+        struct sendq_chunk* n = c->next;
+        free(c);
+        c = n;
+    }
+    q->head = NULL;
+    q->tail = NULL;
+    q->queued = 0;
+}
+
+enum sendq_result PSCHSL__SendqFlush(struct sendq* q, int fd) {
+    while (1) {
+        // drop chunks with nothing left to send so an empty batch never reaches sendmsg
+        while (q->head && q->head->off == q->head->len) {
+            struct sendq_chunk* c = q->head;
+            q->head = c->next;
+            free(c);
+        }
+        if (!q->head) {
+            q->tail = NULL;
+            break;
+        }
+        struct iovec iov[FLUSHIOVS];
+        int n = 0;
+        for (struct sendq_chunk* c = q->head; c && n < FLUSHIOVS; c = c->next, ++n) {
+            iov[n].iov_base = c->data + c->off;
+            iov[n].iov_len = c->len - c->off;
+        }
+        struct msghdr msg = {.msg_iov = iov, .msg_iovlen = n};
+        // tell the kernel if this batch is not the end of what is queued so it does not push out a short segment
+        int more = (q->more || n == FLUSHIOVS) ? MSG_MORE : 0;
+        ssize_t r = sendmsg(fd, &msg, MSG_NOSIGNAL | more);
+        if (r < 0) {
+            if (errno == EINTR) continue;
+            if (errno == EAGAIN || errno == EWOULDBLOCK) return state(q);
+            return SENDQ_ERROR;
+        }
+        q->queued -= r;
+        while (r) {
+            struct sendq_chunk* c = q->head;
+            size_t left = c->len - c->off;
+            if ((size_t)r < left) {
+                c->off += r;
+                break;
+            }
+            r -= left;
+            q->head = c->next;
+            if (!q->head) q->tail = NULL;
+            free(c);
+        }
+    }
+    return SENDQ_DONE;
+}
+
+enum sendq_result PSCHSL__SendqPut(struct sendq* q, int fd, const void* d, size_t l, bool more) {
+    if (!sendq_canput(q)) return SENDQ_FULL;
+    q->more = more;
+    if (!l) return state(q);
+    if (!q->head) {
+        while (l) {
+            ssize_t r = send(fd, d, l, MSG_NOSIGNAL | ((more) ? MSG_MORE : 0));
+            if (r < 0) {
+                if (errno == EINTR) continue;
+                if (errno == EAGAIN || errno == EWOULDBLOCK) break;
+                return SENDQ_ERROR;
+            }
+            d = (const char*)d + r;
+            l -= r;
+        }
+        if (!l) return SENDQ_DONE;
+    }
+    if (!enqueue(q, d, l)) return SENDQ_ERROR;
+    return SENDQ_PENDING;
+}
+
+enum sendq_result PSCHSL__SendqWait(struct sendq* q, int fd, int timeout) {
+    while (!sendq_resumable(q)) {
+        struct pollfd p = {.fd = fd, .events = POLLOUT};
+        int r = poll(&p, 1, timeout);
+        if (r < 0) {
+            if (errno == EINTR) continue;
+            return SENDQ_ERROR;
+        }
+        if (!r) return state(q);
+        if (p.revents & (POLLERR | POLLHUP | POLLNVAL)) return SENDQ_ERROR;
+        if (PSCHSL__SendqFlush(q, fd) == SENDQ_ERROR) return SENDQ_ERROR;
+    }
+    return state(q);
+}
+
+#endif
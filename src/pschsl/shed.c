@@ -0,0 +1,69 @@
+#include "private/shed.h"
+#include "private/atomic.h"
+
+#include <stdio.h>
+#include <errno.h>
+
+void PSCHSL__ShedInit(struct shed* s) {
+    s->maxconns = 0;
+    s->maxinflight = 0;
+    s->maxqdelay = 0;
+    s->acceptpause = 100000;
+    s->conns = 0;
+    s->inflight = 0;
+    s->acceptpausedtill = 0;
+    PSCHSL__ShedSetRetryAfter(s, 1);
+}
+
+void PSCHSL__ShedSetRetryAfter(struct shed* s, unsigned secs) {
+    int l = snprintf(
+        s->resp, sizeof(s->resp),
+        "HTTP/1.1 503 Service Unavailable\r\nRetry-After: %u\r\nContent-Length: 0\r\nConnection: close\r\n\r\n",
+        secs
+    );
+    s->resplen = l;
+}
+
+// Increments the counter only if it stays within the limit, so a burst cannot overshoot it
+static inline bool take(volatile unsigned* c, unsigned max) {
+    if (!max) {
+        atomicinc(c);
+        return true;
+    }
+    unsigned v = atomicload(c);
+    do {
+        if (v >= max) return false;
+    } while (!atomiccas(c, v, v + 1));
+    return true;
+}
+
+bool PSCHSL__ShedTakeConn(struct shed* s) {
+    return take(&s->conns, s->maxconns);
+}
+
+void PSCHSL__ShedReleaseConn(struct shed* s) {
+    atomicdec(&s->conns);
+}
+
+bool PSCHSL__ShedTakeRqst(struct shed* s, uint64_t queuedat, uint64_t now) {
+    if (s->maxqdelay && now > queuedat && now - queuedat > s->maxqdelay) return false;
+    return take(&s->inflight, s->maxinflight);
+}
+
+void PSCHSL__ShedReleaseRqst(struct shed* s) {
+    atomicdec(&s->inflight);
+}
+
+bool PSCHSL__ShedAcceptFailed(struct shed* s, int err, uint64_t now) {
+    switch (err) {
+        case EMFILE:
+        case ENFILE:
+        case ENOBUFS:
+        case ENOMEM:
+            // the pending connection stays in the backlog; spinning on accept would only burn CPU until an fd frees up
+            s->acceptpausedtill = now + s->acceptpause;
+            return true;
+        default:
+            return false;
+    }
+}
@@ -0,0 +1,268 @@
+#include "private/sock.h"
+
+#ifndef _WIN32
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+
+#ifndef SOCK_CLOEXEC
+    #define SOCK_CLOEXEC 0
+#endif
+#if defined(__linux__) || defined(__FreeBSD__) || defined(__NetBSD__) || defined(__OpenBSD__) || defined(__DragonFly__)
+    #define HAVE_ACCEPT4
+#endif
+
+bool PSCHSL__SendFds(int s, const int* fds, unsigned c) {
+    if (!c || c > SOCK_MAXPASSFDS) return false;
+    // the count is also sent as the payload so the receiver can tell if the control data was truncated
+    uint8_t n = c;
+    struct iovec iov = {.iov_base = &n, .iov_len = 1};
+    union {
+        struct cmsghdr align;
+        char buf[CMSG_SPACE(sizeof(int) * SOCK_MAXPASSFDS)];
+    } cbuf;
+    memset(&cbuf, 0, sizeof(cbuf));
+    struct msghdr msg = {
+        .msg_iov = &iov,
+        .msg_iovlen = 1,
+        .msg_control = cbuf.buf,
+        .msg_controllen = CMSG_SPACE(sizeof(int) * c)
+    };
+    struct cmsghdr* cmsg = CMSG_FIRSTHDR(&msg);
+    cmsg->cmsg_level = SOL_SOCKET;
+    cmsg->cmsg_type = SCM_RIGHTS;
+    cmsg->cmsg_len = CMSG_LEN(sizeof(int) * c);
+    memcpy(CMSG_DATA(cmsg), fds, sizeof(int) * c);
+    ssize_t r;
+    do {
+        r = sendmsg(s, &msg, 0);
+    } while (r < 0 && errno == EINTR);
+    return (r == 1);
+}
+
+unsigned PSCHSL__RecvFds(int s, int* fds, unsigned max) {
+    if (max > SOCK_MAXPASSFDS) max = SOCK_MAXPASSFDS;
+    uint8_t n;
+    struct iovec iov = {.iov_base = &n, .iov_len = 1};
+    union {
+        struct cmsghdr align;
+        char buf[CMSG_SPACE(sizeof(int) * SOCK_MAXPASSFDS)];
+    } cbuf;
+    struct msghdr msg = {
+        .msg_iov = &iov,
+        .msg_iovlen = 1,
+        .msg_control = cbuf.buf,
+        .msg_controllen = sizeof(cbuf.buf)
+    };
+    ssize_t r;
+    do {
+        #ifdef MSG_CMSG_CLOEXEC
+        r = recvmsg(s, &msg, MSG_CMSG_CLOEXEC);
+        #else
+        r = recvmsg(s, &msg, 0);
+        #endif
+    } while (r < 0 && errno == EINTR);
+    if (r != 1) return 0;
+    unsigned c = 0;
+    bool bad = (msg.msg_flags & MSG_CTRUNC);
+    for (struct cmsghdr* cmsg = CMSG_FIRSTHDR(&msg); cmsg; cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+        if (cmsg->cmsg_level != SOL_SOCKET || cmsg->cmsg_type != SCM_RIGHTS) continue;
+        unsigned cc = (cmsg->cmsg_len - CMSG_LEN(0)) / sizeof(int);
+        for (unsigned i = 0; i < cc; ++i) {
+            int fd;
+            memcpy(&fd, CMSG_DATA(cmsg) + i * sizeof(int), sizeof(int));
+            if (c < max) {
+                #ifndef MSG_CMSG_CLOEXEC
+                fcntl(fd, F_SETFD, FD_CLOEXEC);
+                #endif
+                fds[c++] = fd;
+            } else {
+                close(fd);
+                bad = true;
+            }
+        }
+    }
+    if (bad || c != n) {
+        for (unsigned i = 0; i < c; ++i) close(fds[i]);
+        return 0;
+    }
+    return c;
+}
+
+bool PSCHSL__IsListener(int fd) {
+    #ifdef SO_ACCEPTCONN
+    int v = 0;
+    socklen_t l = sizeof(v);
+    if (getsockopt(fd, SOL_SOCKET, SO_ACCEPTCONN, &v, &l)) return false;
+    return v;
+    #else
+    int t = 0;
+    socklen_t l = sizeof(t);
+    if (getsockopt(fd, SOL_SOCKET, SO_TYPE, &t, &l)) return false;
+    return (t == SOCK_STREAM);
+    #endif
+}
+
+int PSCHSL__GetSockCpu(int fd) {
+    #ifdef SO_INCOMING_CPU
+    int v = -1;
+    socklen_t l = sizeof(v);
+    if (getsockopt(fd, SOL_SOCKET, SO_INCOMING_CPU, &v, &l)) return -1;
+    return v;
+    #else
+    (void)fd;
+    return -1;
+    #endif
+}
+
+int PSCHSL__ListenTCP(const char* addr, unsigned port, int backlog) {
+    char portstr[8];
+    if (port > 65535) return -1;
+    snprintf(portstr, sizeof(portstr), "%u", port);
+    struct addrinfo hints = {
+        .ai_family = AF_UNSPEC, .ai_socktype = SOCK_STREAM, .ai_flags = AI_PASSIVE | AI_NUMERICHOST
+    };
+    struct addrinfo* res;
+    if (getaddrinfo(addr, portstr, &hints, &res)) return -1;
+    int fd = -1;
+    for (struct addrinfo* ai = res; ai; ai = ai->ai_next) {
+        fd = socket(ai->ai_family, ai->ai_socktype | SOCK_CLOEXEC, ai->ai_protocol);
+        if (fd < 0) continue;
+        int one = 1;
+        setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+        if (!bind(fd, ai->ai_addr, ai->ai_addrlen) && !listen(fd, backlog)) break;
+        close(fd);
+        fd = -1;
+    }
+    freeaddrinfo(res);
+    return fd;
+}
+
+// Checks if nothing is listening on a socket file anymore (e.g. it was left behind by a crash)
+//   - A server that is still running (like the one handing its listeners over) must keep its socket
+static bool stalesock(const struct sockaddr_un* sa, socklen_t salen) {
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0) return false;
+    // non-blocking so that a full backlog reports EAGAIN instead of waiting
+    int fl = fcntl(fd, F_GETFL);
+    if (fl < 0 || fcntl(fd, F_SETFL, fl | O_NONBLOCK) < 0) {
+        close(fd);
+        return false;
+    }
+    bool stale = (connect(fd, (const struct sockaddr*)sa, salen) && errno == ECONNREFUSED);
+    close(fd);
+    return stale;
+}
+
+int PSCHSL__ListenUnix(const char* path, int perms, int backlog) {
+    struct sockaddr_un sa;
+    memset(&sa, 0, sizeof(sa));
+    sa.sun_family = AF_UNIX;
+    size_t l = strlen(path);
+    if (!l || l >= sizeof(sa.sun_path)) return -1;
+    socklen_t salen;
+    bool abstract = (*path == '@');
+    if (abstract) {
+        #ifdef __linux__
+        // abstract names start with a NUL and are not NUL-terminated
+        memcpy(sa.sun_path + 1, path + 1, l - 1);
+        salen = offsetof(struct sockaddr_un, sun_path) + l;
+        #else
+        return -1;
+        #endif
+    } else {
+        memcpy(sa.sun_path, path, l);
+        salen = offsetof(struct sockaddr_un, sun_path) + l + 1;
+        struct stat st;
+        // only remove what is actually a socket so that a typo cannot delete a regular file
+        if (!lstat(path, &st)) {
+            if (!S_ISSOCK(st.st_mode) || !stalesock(&sa, salen)) return -1;
+            unlink(path);
+        }
+    }
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0) return -1;
+    if (bind(fd, (struct sockaddr*)&sa, salen)) goto fail;
+    // nobody can connect before listen, so there is no window where the socket has the wrong permissions
+    if (!abstract && perms >= 0 && chmod(path, perms)) goto fail_unlink;
+    if (listen(fd, backlog)) goto fail_unlink;
+    return fd;
+    fail_unlink:;
+    if (!abstract) unlink(path);
+    fail:;
+    close(fd);
+    return -1;
+}
+
+static inline void setint(int fd, int level, int opt, int v) {
+    setsockopt(fd, level, opt, &v, sizeof(v));
+}
+
+void PSCHSL__TuneListener(int fd, const struct socktune* t) {
+    #ifdef TCP_DEFER_ACCEPT
+    if (t->deferaccept) setint(fd, IPPROTO_TCP, TCP_DEFER_ACCEPT, t->deferaccept);
+    #endif
+    #ifdef TCP_FASTOPEN
+    if (t->fastopen) setint(fd, IPPROTO_TCP, TCP_FASTOPEN, t->fastopen);
+    #endif
+    if (t->sndbuf) setint(fd, SOL_SOCKET, SO_SNDBUF, t->sndbuf);
+    if (t->rcvbuf) setint(fd, SOL_SOCKET, SO_RCVBUF, t->rcvbuf);
+}
+
+void PSCHSL__TuneConn(int fd, const struct socktune* t) {
+    if (t->nodelay) setint(fd, IPPROTO_TCP, TCP_NODELAY, 1);
+    #ifdef SO_BUSY_POLL
+    if (t->busypoll) setint(fd, SOL_SOCKET, SO_BUSY_POLL, t->busypoll);
+    #endif
+    if (t->sndbuf) setint(fd, SOL_SOCKET, SO_SNDBUF, t->sndbuf);
+    if (t->rcvbuf) setint(fd, SOL_SOCKET, SO_RCVBUF, t->rcvbuf);
+}
+
+unsigned PSCHSL__AcceptBatch(int lfd, int* fds, unsigned max, int* err) {
+    unsigned c = 0;
+    while (c < max) {
+        #ifdef HAVE_ACCEPT4
+        int fd = accept4(lfd, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        #else
+        int fd = accept(lfd, NULL, NULL);
+        if (fd >= 0) {
+            fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+            fcntl(fd, F_SETFD, FD_CLOEXEC);
+        }
+        #endif
+        if (fd < 0) {
+            if (errno == EINTR) continue;
+            // the client may have given up while in the backlog; that says nothing about the next one
+            if (errno == ECONNABORTED) continue;
+            if (!c) *err = (errno == EWOULDBLOCK) ? EAGAIN : errno;
+            break;
+        }
+        fds[c++] = fd;
+    }
+    return c;
+}
+
+void PSCHSL__SetCork(int fd, bool on) {
+    #if defined(TCP_CORK)
+    setint(fd, IPPROTO_TCP, TCP_CORK, on);
+    #elif defined(TCP_NOPUSH)
+    setint(fd, IPPROTO_TCP, TCP_NOPUSH, on);
+    #else
+    (void)fd; (void)on;
+    #endif
+}
+
+#endif
@@ -1,22 +1,33 @@
 #include "private/threading.h"
+#include "private/trace.h"
 
 #undef createThread
 #undef quitThread
 #undef destroyThread
+#undef createThreadOnCpus
+#undef pinCurrentThread
+#undef getCurrentCpu
 
 #include <stddef.h>
 #include <stdlib.h>
 #include <string.h>
+#if defined(__GLIBC__)
+    #include <sched.h>
+#endif
 
 #if defined(_WIN32) && !defined(PSCHSL_THREADING_USEWINPTHREAD) && !defined(PSCHSL_THREADING_USESTDTHREAD)
 static DWORD WINAPI threadwrapper(LPVOID t) {
+    if (((thread_t*)t)->cpucount) PSCHSL__PinCurrentThread(((thread_t*)t)->cpus, ((thread_t*)t)->cpucount);
     ((thread_t*)t)->ret = ((thread_t*)t)->func(&((thread_t*)t)->data);
+    PSCHSL__TraceThreadEnd();
     ExitThread(0);
     return 0;
 }
 #elif defined(PSCHSL_THREADING_USESTDTHREAD)
 static int threadwrapper(void* t) {
+    if (((thread_t*)t)->cpucount) PSCHSL__PinCurrentThread(((thread_t*)t)->cpus, ((thread_t*)t)->cpucount);
     ((thread_t*)t)->ret = ((thread_t*)t)->func(&((thread_t*)t)->data);
+    PSCHSL__TraceThreadEnd();
     thrd_exit(0);
     return 0;
 }
@@ -33,13 +44,28 @@ static void* threadwrapper(void* t) {
             #endif
         #endif
     #endif
+    // pin before running anything so that memory the thread touches first ends up on the CPU's NUMA node
+    if (((thread_t*)t)->cpucount) PSCHSL__PinCurrentThread(((thread_t*)t)->cpus, ((thread_t*)t)->cpucount);
     ((thread_t*)t)->ret = ((thread_t*)t)->func(&((thread_t*)t)->data);
+    PSCHSL__TraceThreadEnd();
     pthread_exit(((thread_t*)t)->ret);
     return ((thread_t*)t)->ret;
 }
 #endif
 
 bool PSCHSL__CreateThread(thread_t* t, const char* n, threadfunc_t f, void* a) {
+    return PSCHSL__CreateThreadOnCpus(t, n, f, a, NULL, 0);
+}
+
+bool PSCHSL__CreateThreadOnCpus(thread_t* t, const char* n, threadfunc_t f, void* a, const unsigned* c, unsigned cc) {
+    if (cc) {
+        t->cpus = malloc(cc * sizeof(*c));
+        if (!t->cpus) return false;
+        memcpy(t->cpus, c, cc * sizeof(*c));
+    } else {
+        t->cpus = NULL;
+    }
+    t->cpucount = cc;
     t->name = (n) ? strdup(n) : NULL;
     t->func = f;
     t->data.self = t;
@@ -57,6 +83,7 @@ bool PSCHSL__CreateThread(thread_t* t, const char* n, threadfunc_t f, void* a) {
     #endif
     if (fail) {
         free(t->name);
+        free(t->cpus);
         return false;
     }
     return true;
@@ -80,4 +107,61 @@ void PSCHSL__DestroyThread(thread_t* t, void** r) {
         if (r) *r = t->ret;
     #endif
     free(t->name);
+    free(t->cpus);
+}
+
+#if defined(__GLIBC__)
+static bool pinglibc(const unsigned* c, unsigned cc) {
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (unsigned i = 0; i < cc; ++i) {
+        if (c[i] >= CPU_SETSIZE) return false;
+        CPU_SET(c[i], &set);
+    }
+    return !sched_setaffinity(0, sizeof(set), &set);
+}
+#endif
+
+bool PSCHSL__PinCurrentThread(const unsigned* c, unsigned cc) {
+    if (!cc) return true;
+    #ifndef PSCHSL_THREADING_USESTDTHREAD
+        #if defined(_WIN32) && !defined(PSCHSL_THREADING_USEWINPTHREAD)
+            DWORD_PTR mask = 0;
+            for (unsigned i = 0; i < cc; ++i) {
+                if (c[i] >= sizeof(mask) * 8) return false;
+                mask |= (DWORD_PTR)1 << c[i];
+            }
+            return (SetThreadAffinityMask(GetCurrentThread(), mask) != 0);
+        #elif defined(__GLIBC__)
+            return pinglibc(c, cc);
+        #else
+            (void)c;
+            return false;
+        #endif
+    #else
+        #if defined(__GLIBC__)
+            return pinglibc(c, cc);
+        #else
+            (void)c;
+            return false;
+        #endif
+    #endif
+}
+
+int PSCHSL__GetCurrentCpu(void) {
+    #ifndef PSCHSL_THREADING_USESTDTHREAD
+        #if defined(_WIN32) && !defined(PSCHSL_THREADING_USEWINPTHREAD)
+            return GetCurrentProcessorNumber();
+        #elif defined(__GLIBC__)
+            return sched_getcpu();
+        #else
+            return -1;
+        #endif
+    #else
+        #if defined(__GLIBC__)
+            return sched_getcpu();
+        #else
+            return -1;
+        #endif
+    #endif
 }
@@ -0,0 +1,108 @@
+#include "private/trace.h"
+#include "private/threading.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+volatile bool PSCHSL__traceon = true;
+#ifndef _MSC_VER
+__thread struct trace_ring* PSCHSL__tracering = NULL;
+#else
+__declspec(thread) struct trace_ring* PSCHSL__tracering = NULL;
+#endif
+
+static struct trace_ring* rings = NULL;
+static uint32_t nexttid = 1;
+static mutex_t ringlock;
+static volatile bool ringlockready = false;
+
+#ifndef PSCHSL_THREADING_USESTDTHREAD
+    #if defined(_WIN32) && !defined(PSCHSL_THREADING_USEWINPTHREAD)
+    static INIT_ONCE ringlockonce = INIT_ONCE_STATIC_INIT;
+    static BOOL CALLBACK initringlock(PINIT_ONCE o, PVOID p, PVOID* c) {
+        (void)o; (void)p; (void)c;
+        ringlockready = createMutex(&ringlock);
+        return TRUE;
+    }
+    #define initlock() InitOnceExecuteOnce(&ringlockonce, initringlock, NULL, NULL)
+    #else
+    static pthread_once_t ringlockonce = PTHREAD_ONCE_INIT;
+    static void initringlock(void) {
+        ringlockready = createMutex(&ringlock);
+    }
+    #define initlock() pthread_once(&ringlockonce, initringlock)
+    #endif
+#else
+    static once_flag ringlockonce = ONCE_FLAG_INIT;
+    static void initringlock(void) {
+        ringlockready = createMutex(&ringlock);
+    }
+    #define initlock() call_once(&ringlockonce, initringlock)
+#endif
+
+struct trace_ring* PSCHSL__TraceThreadStart(void) {
+    initlock();
+    if (!ringlockready) return NULL;
+    lockMutex(&ringlock);
+    struct trace_ring* r = rings;
+    while (r && r->inuse) r = r->next;
+    if (r) {
+        r->inuse = true;
+    } else {
+        r = malloc(sizeof(*r));
+        if (r) {
+            r->tid = nexttid++;
+            r->inuse = true;
+            r->pos = 0;
+            r->next = rings;
+            rings = r;
+        }
+    }
+    unlockMutex(&ringlock);
+    PSCHSL__tracering = r;
+    return r;
+}
+
+void PSCHSL__TraceThreadEnd(void) {
+    struct trace_ring* r = PSCHSL__tracering;
+    if (!r) return;
+    PSCHSL__tracering = NULL;
+    lockMutex(&ringlock);
+    r->inuse = false;
+    unlockMutex(&ringlock);
+}
+
+static inline uint64_t loadpos(struct trace_ring* r) {
+    return atomicload(&r->pos);
+}
+
+static bool put32(FILE* f, uint32_t v) {
+    return fwrite(&v, sizeof(v), 1, f) == 1;
+}
+
+bool PSCHSL__TraceDump(FILE* f) {
+    initlock();
+    if (!ringlockready) return false;
+    struct trace_rec* buf = malloc(sizeof(*buf) * TRACE_RINGSIZE);
+    if (!buf) return false;
+    bool ok = (fwrite(TRACE_MAGIC, 1, 8, f) == 8 && put32(f, TRACE_VERSION) && put32(f, sizeof(struct trace_rec)));
+    lockMutex(&ringlock);
+    for (struct trace_ring* r = rings; ok && r; r = r->next) {
+        uint64_t end = loadpos(r);
+        uint64_t start = (end > TRACE_RINGSIZE) ? end - TRACE_RINGSIZE : 0;
+        for (uint64_t i = start; i < end; ++i) buf[i - start] = r->recs[i & (TRACE_RINGSIZE - 1)];
+        // keep the copy above from being reordered past the second load
+        atomicacquire();
+        // anything the writer lapped while copying may be torn, so drop it; the writer may also be filling the slot of
+        // record after - TRACE_RINGSIZE right now, so that one goes too
+        uint64_t after = loadpos(r);
+        uint64_t skip = 0;
+        if (after + 1 > TRACE_RINGSIZE && after + 1 - TRACE_RINGSIZE > start) skip = after + 1 - TRACE_RINGSIZE - start;
+        if (skip > end - start) skip = end - start;
+        uint32_t count = end - start - skip;
+        ok = (put32(f, r->tid) && put32(f, count) && fwrite(buf + skip, sizeof(*buf), count, f) == count);
+    }
+    unlockMutex(&ringlock);
+    free(buf);
+    return ok && !fflush(f);
+}
@@ -0,0 +1,220 @@
+#include "private/uri.h"
+
+#include <stdint.h>
+#include <string.h>
+#if defined(__SSE2__)
+    #include <emmintrin.h>
+#endif
+
+// Bytes that the path decoder has to stop at ('%', '/', '?', '#', and control chars)
+static const uint8_t pathspecial[256] = {
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+    1, 0, 0, 1, 0, 1, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1
+};
+
+static inline int hexval(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    c |= 0x20;
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    return -1;
+}
+
+// Returns the offset of the first special byte in s[0..len), or len if there is none
+static inline size_t skipplain(const char* s, size_t len) {
+    size_t i = 0;
+    #if defined(__SSE2__)
+    const __m128i pct = _mm_set1_epi8('%');
+    const __m128i slash = _mm_set1_epi8('/');
+    const __m128i qmark = _mm_set1_epi8('?');
+    const __m128i hash = _mm_set1_epi8('#');
+    const __m128i sp = _mm_set1_epi8(0x21);
+    const __m128i del = _mm_set1_epi8(0x7F);
+    const __m128i neg1 = _mm_set1_epi8(-1);
+    for (; i + 16 <= len; i += 16) {
+        __m128i v = _mm_loadu_si128((const __m128i*)(s + i));
+        __m128i m = _mm_or_si128(
+            _mm_or_si128(_mm_cmpeq_epi8(v, pct), _mm_cmpeq_epi8(v, slash)),
+            _mm_or_si128(_mm_cmpeq_epi8(v, qmark), _mm_cmpeq_epi8(v, hash))
+        );
+        // control chars are 0x00-0x20 and 0x7F; bytes >= 0x80 are negative here and get masked out
+        __m128i ctl = _mm_and_si128(_mm_cmplt_epi8(v, sp), _mm_cmpgt_epi8(v, neg1));
+        m = _mm_or_si128(m, _mm_or_si128(ctl, _mm_cmpeq_epi8(v, del)));
+        unsigned bits = _mm_movemask_epi8(m);
+        if (bits) return i + __builtin_ctz(bits);
+    }
+    #endif
+    for (; i < len; ++i) {
+        if (pathspecial[(uint8_t)s[i]]) break;
+    }
+    return i;
+}
+
+// Handles the end of the segment that starts at segstart and ends at *w
+//   - Returns the new segment start
+static inline size_t endseg(char* o, size_t segstart, size_t* w, bool sep) {
+    size_t l = *w - segstart;
+    if (l == 1 && o[segstart] == '.') {
+        *w = segstart;
+        return segstart;
+    }
+    if (l == 2 && o[segstart] == '.' && o[segstart + 1] == '.') {
+        size_t nw = segstart;
+        if (nw > 1) {
+            --nw;
+            while (nw > 0 && o[nw - 1] != '/') --nw;
+        }
+        *w = nw;
+        return nw;
+    }
+    if (sep) o[(*w)++] = '/';
+    return *w;
+}
+
+enum uri_result PSCHSL__DecodeURI(struct uri* u, char* s, size_t len, size_t maxlen, bool canon) {
+    if (len > maxlen) return URI_TOOLONG;
+    u->query = NULL;
+    u->querylen = 0;
+    u->qparsed = false;
+    VLB_SBO_INIT(u->qparams);
+    size_t r = 0;
+    if (len == 1 && *s == '*') {
+        u->path = s;
+        u->pathlen = 1;
+        s[1] = 0;
+        return URI_OK;
+    }
+    if (!len) return URI_BAD;
+    if (*s != '/') {
+        // absolute-form; skip the scheme and authority
+        const char* p = memchr(s, ':', len);
+        if (!p || (size_t)(p - s) + 3 > len || p[1] != '/' || p[2] != '/') return URI_BAD;
+        r = p - s + 3;
+        while (r < len && s[r] != '/' && s[r] != '?' && s[r] != '#') ++r;
+        if (r == len || s[r] != '/') {
+            // no path; use "/" (overwriting the last char of the authority is fine as w never passes r)
+            --r;
+            s[r] = '/';
+        }
+    }
+    char* o = s + r;
+    size_t w = 0;
+    size_t segstart = 1;
+    o[w++] = '/';
+    ++r;
+    while (r < len) {
+        size_t n = skipplain(s + r, len - r);
+        if (n) {
+            if (o + w != s + r) memmove(o + w, s + r, n);
+            w += n;
+            r += n;
+            if (r == len) break;
+        }
+        char c = s[r];
+        if (c == '/') {
+            ++r;
+            if (canon) segstart = endseg(o, segstart, &w, true);
+            else {o[w++] = '/'; segstart = w;}
+        } else if (c == '%') {
+            if (r + 2 >= len) return URI_BAD;
+            int h = hexval(s[r + 1]), l = hexval(s[r + 2]);
+            if (h < 0 || l < 0) return URI_BAD;
+            c = (h << 4) | l;
+            if (!c) return URI_BAD;
+            r += 3;
+            // an encoded slash still separates segments when canonizing so that the result is safe to map to a path
+            if (c == '/' && canon) segstart = endseg(o, segstart, &w, true);
+            else o[w++] = c;
+        } else if (c == '?') {
+            ++r;
+            size_t e = r;
+            while (e < len && s[e] != '#') ++e;
+            u->query = s + r;
+            u->querylen = e - r;
+            s[e] = 0;
+            break;
+        } else if (c == '#') {
+            break;
+        } else {
+            return URI_BAD;
+        }
+    }
+    if (canon) endseg(o, segstart, &w, false);
+    o[w] = 0;
+    u->path = o;
+    u->pathlen = w;
+    return URI_OK;
+}
+
+static char* decodeqpart(char* s) {
+    char* o = s;
+    char* r = s;
+    while (*r) {
+        if (*r == '+') {
+            *o++ = ' ';
+            ++r;
+        } else if (*r == '%') {
+            int h = hexval(r[1]), l = (h >= 0) ? hexval(r[2]) : -1;
+            if (h < 0 || l < 0 || !((h << 4) | l)) {
+                // leave malformed escapes as they are
+                *o++ = *r++;
+            } else {
+                *o++ = (h << 4) | l;
+                r += 3;
+            }
+        } else {
+            *o++ = *r++;
+        }
+    }
+    *o = 0;
+    return s;
+}
+
+bool PSCHSL__URIParseQuery(struct uri* u) {
+    if (u->qparsed) return true;
+    if (!u->query || !u->querylen) {
+        u->qparsed = true;
+        return true;
+    }
+    size_t c = 1;
+    for (size_t i = 0; i < u->querylen; ++i) {
+        if (u->query[i] == '&') ++c;
+    }
+    VLB_SBO_EXPANDTO(u->qparams, c, 2, 1, return false;);
+    u->qparams.len = 0;
+    char* p = u->query;
+    char* e = u->query + u->querylen;
+    while (p < e) {
+        char* n = memchr(p, '&', e - p);
+        if (!n) n = e;
+        *n = 0;
+        if (n != p) {
+            struct uri_qparam* qp = &u->qparams.data[u->qparams.len++];
+            char* eq = strchr(p, '=');
+            if (eq) {
+                *eq = 0;
+                qp->value = decodeqpart(eq + 1);
+            } else {
+                qp->value = n;
+            }
+            qp->name = decodeqpart(p);
+        }
+        p = n + 1;
+    }
+    u->qparsed = true;
+    return true;
+}
+
+const char* PSCHSL__URIGetQueryParam(struct uri* u, const char* name) {
+    if (!PSCHSL__URIParseQuery(u)) return NULL;
+    for (size_t i = 0; i < u->qparams.len; ++i) {
+        if (!strcmp(u->qparams.data[i].name, name)) return u->qparams.data[i].value;
+    }
+    return NULL;
+}
+
+void PSCHSL__FreeURI(struct uri* u) {
+    VLB_SBO_FREE(u->qparams);
+    VLB_SBO_INIT(u->qparams);
+}
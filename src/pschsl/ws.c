@@ -0,0 +1,528 @@
+#include "private/ws.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#if defined(__SSE2__)
+    #include <emmintrin.h>
+#endif
+
+#define WS_GUID "258EAFA5-E914-47DA-95CA-C5AB0DC85B11"
+#define WS_POOLKEEPMAX 65536
+// Amount of output room to make before each inflate or deflate call
+#define WS_ZCHUNK 16384
+
+static inline uint32_t rol(uint32_t v, unsigned n) {
+    return (v << n) | (v >> (32 - n));
+}
+
+static void sha1block(uint32_t h[5], const uint8_t* b) {
+    uint32_t w[80];
+    for (int i = 0; i < 16; ++i) {
+        const uint8_t* p = b + i * 4;
+        w[i] = ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | p[3];
+    }
+    for (int i = 16; i < 80; ++i) w[i] = rol(w[i - 3] ^ w[i - 8] ^ w[i - 14] ^ w[i - 16], 1);
+    uint32_t a = h[0], bb = h[1], c = h[2], d = h[3], e = h[4];
+    for (int i = 0; i < 80; ++i) {
+        uint32_t f, k;
+        if (i < 20) {f = (bb & c) | (~bb & d); k = 0x5A827999;}
+        else if (i < 40) {f = bb ^ c ^ d; k = 0x6ED9EBA1;}
+        else if (i < 60) {f = (bb & c) | (bb & d) | (c & d); k = 0x8F1BBCDC;}
+        else {f = bb ^ c ^ d; k = 0xCA62C1D6;}
+        uint32_t t = rol(a, 5) + f + e + k + w[i];
+        e = d;
+        d = c;
+        c = rol(bb, 30);
+        bb = a;
+        a = t;
+    }
+    h[0] += a;
+    h[1] += bb;
+    h[2] += c;
+    h[3] += d;
+    h[4] += e;
+}
+
+static void sha1(const uint8_t* d, size_t l, uint8_t out[20]) {
+    uint32_t h[5] = {0x67452301, 0xEFCDAB89, 0x98BADCFE, 0x10325476, 0xC3D2E1F0};
+    size_t i = 0;
+    for (; i + 64 <= l; i += 64) sha1block(h, d + i);
+    uint8_t last[128] = {0};
+    size_t rem = l - i;
+    memcpy(last, d + i, rem);
+    last[rem] = 0x80;
+    size_t lastlen = (rem < 56) ? 64 : 128;
+    uint64_t bits = (uint64_t)l * 8;
+    for (int j = 0; j < 8; ++j) last[lastlen - 1 - j] = bits >> (j * 8);
+    sha1block(h, last);
+    if (lastlen == 128) sha1block(h, last + 64);
+    for (int j = 0; j < 5; ++j) {
+        out[j * 4] = h[j] >> 24;
+        out[j * 4 + 1] = h[j] >> 16;
+        out[j * 4 + 2] = h[j] >> 8;
+        out[j * 4 + 3] = h[j];
+    }
+}
+
+void PSCHSL__WSAcceptKey(const char* key, char out[WS_ACCEPTSIZE]) {
+    static const char b64[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    uint8_t buf[128];
+    size_t kl = strlen(key);
+    if (kl > sizeof(buf) - (sizeof(WS_GUID) - 1)) kl = sizeof(buf) - (sizeof(WS_GUID) - 1);
+    memcpy(buf, key, kl);
+    memcpy(buf + kl, WS_GUID, sizeof(WS_GUID) - 1);
+    uint8_t h[21];
+    sha1(buf, kl + sizeof(WS_GUID) - 1, h);
+    h[20] = 0;
+    char* o = out;
+    for (int i = 0; i < 21; i += 3) {
+        uint32_t v = ((uint32_t)h[i] << 16) | ((uint32_t)h[i + 1] << 8) | ((i + 2 < 21) ? h[i + 2] : 0);
+        *o++ = b64[(v >> 18) & 63];
+        *o++ = b64[(v >> 12) & 63];
+        *o++ = b64[(v >> 6) & 63];
+        *o++ = b64[v & 63];
+    }
+    // 20 bytes make 27 chars plus one '=' of padding
+    out[27] = '=';
+    out[28] = 0;
+}
+
+int PSCHSL__WSParseFrameHdr(const uint8_t* in, size_t l, uint8_t allowrsv, struct wsframe* f) {
+    if (l < 2) return 0;
+    f->fin = (in[0] & 0x80);
+    f->rsv = in[0] & 0x70;
+    if (f->rsv & ~allowrsv) return -1;
+    f->opcode = in[0] & 0x0F;
+    f->masked = (in[1] & 0x80);
+    uint64_t pl = in[1] & 0x7F;
+    size_t hl = 2;
+    if (pl == 126) {
+        if (l < 4) return 0;
+        pl = ((uint64_t)in[2] << 8) | in[3];
+        hl = 4;
+    } else if (pl == 127) {
+        if (l < 10) return 0;
+        pl = 0;
+        for (int i = 0; i < 8; ++i) pl = (pl << 8) | in[2 + i];
+        if (pl >> 63) return -1;
+        hl = 10;
+    }
+    if (f->opcode & 0x8) {
+        if (f->opcode > WS_OP_PONG || !f->fin || pl > 125 || f->rsv) return -1;
+    } else if (f->opcode > WS_OP_BINARY) {
+        return -1;
+    }
+    // clients must mask everything
+    if (!f->masked) return -1;
+    if (l < hl + 4) return 0;
+    memcpy(f->mask, in + hl, 4);
+    f->len = pl;
+    return hl + 4;
+}
+
+size_t PSCHSL__WSPutFrameHdr(uint8_t o[WS_MAXFRAMEHDRLEN], bool fin, enum ws_opcode op, uint64_t l) {
+    o[0] = ((fin) ? 0x80 : 0) | op;
+    if (l < 126) {
+        o[1] = l;
+        return 2;
+    }
+    if (l <= 0xFFFF) {
+        o[1] = 126;
+        o[2] = l >> 8;
+        o[3] = l;
+        return 4;
+    }
+    o[1] = 127;
+    for (int i = 0; i < 8; ++i) o[2 + i] = l >> ((7 - i) * 8);
+    return 10;
+}
+
+void PSCHSL__WSUnmask(uint8_t* d, size_t l, const uint8_t mask[4], uint64_t off) {
+    uint8_t m[4];
+    for (int i = 0; i < 4; ++i) m[i] = mask[(off + i) & 3];
+    size_t i = 0;
+    #if defined(__SSE2__)
+    if (l >= 16) {
+        uint32_t m32;
+        memcpy(&m32, m, 4);
+        const __m128i mv = _mm_set1_epi32(m32);
+        for (; i + 64 <= l; i += 64) {
+            __m128i a = _mm_loadu_si128((const __m128i*)(d + i));
+            __m128i b = _mm_loadu_si128((const __m128i*)(d + i + 16));
+            __m128i c = _mm_loadu_si128((const __m128i*)(d + i + 32));
+            __m128i e = _mm_loadu_si128((const __m128i*)(d + i + 48));
+            _mm_storeu_si128((__m128i*)(d + i), _mm_xor_si128(a, mv));
+            _mm_storeu_si128((__m128i*)(d + i + 16), _mm_xor_si128(b, mv));
+            _mm_storeu_si128((__m128i*)(d + i + 32), _mm_xor_si128(c, mv));
+            _mm_storeu_si128((__m128i*)(d + i + 48), _mm_xor_si128(e, mv));
+        }
+        for (; i + 16 <= l; i += 16) {
+            __m128i a = _mm_loadu_si128((const __m128i*)(d + i));
+            _mm_storeu_si128((__m128i*)(d + i), _mm_xor_si128(a, mv));
+        }
+    }
+    #else
+    if (l >= 8) {
+        uint64_t m64;
+        memcpy(&m64, m, 4);
+        memcpy((uint8_t*)&m64 + 4, m, 4);
+        for (; i + 8 <= l; i += 8) {
+            uint64_t v;
+            memcpy(&v, d + i, 8);
+            v ^= m64;
+            memcpy(d + i, &v, 8);
+        }
+    }
+    #endif
+    // i is always a multiple of 4 here, so the mask lines up again
+    for (; i < l; ++i) d[i] ^= m[i & 3];
+}
+
+bool PSCHSL__UTF8Valid(const uint8_t* s, size_t l) {
+    size_t i = 0;
+    while (i < l) {
+        // skip ASCII 8 bytes at a time
+        if (i + 8 <= l) {
+            uint64_t v;
+            memcpy(&v, s + i, 8);
+            if (!(v & 0x8080808080808080ULL)) {
+                i += 8;
+                continue;
+            }
+        }
+        uint8_t c = s[i];
+        if (c < 0x80) {
+            ++i;
+            continue;
+        }
+        size_t n;
+        uint32_t cp;
+        if ((c & 0xE0) == 0xC0) {n = 1; cp = c & 0x1F;}
+        else if ((c & 0xF0) == 0xE0) {n = 2; cp = c & 0x0F;}
+        else if ((c & 0xF8) == 0xF0) {n = 3; cp = c & 0x07;}
+        else return false;
+        if (i + n >= l) return false;
+        for (size_t j = 1; j <= n; ++j) {
+            if ((s[i + j] & 0xC0) != 0x80) return false;
+            cp = (cp << 6) | (s[i + j] & 0x3F);
+        }
+        // overlong forms, surrogates and out of range code points
+        if ((n == 1 && cp < 0x80) || (n == 2 && cp < 0x800) || (n == 3 && cp < 0x10000)) return false;
+        if ((cp >= 0xD800 && cp <= 0xDFFF) || cp > 0x10FFFF) return false;
+        i += n + 1;
+    }
+    return true;
+}
+
+static inline const char* skipows(const char* s) {
+    while (*s == ' ' || *s == '\t') ++s;
+    return s;
+}
+
+// Compares a token that ends at e against a lowercase name
+static inline bool tokeq(const char* s, const char* e, const char* name) {
+    size_t l = strlen(name);
+    if ((size_t)(e - s) != l) return false;
+    for (size_t i = 0; i < l; ++i) {
+        char c = s[i];
+        if (c >= 'A' && c <= 'Z') c += 'a' - 'A';
+        if (c != name[i]) return false;
+    }
+    return true;
+}
+
+// Parses the value of a window bits param (which may be quoted); returns 0 if it is invalid
+static unsigned parsebits(const char* s, const char* e) {
+    if (e - s >= 2 && *s == '"' && e[-1] == '"') {
+        ++s;
+        --e;
+    }
+    if (e - s == 1 && *s >= '8' && *s <= '9') return *s - '0';
+    if (e - s == 2 && *s == '1' && s[1] >= '0' && s[1] <= '5') return 10 + s[1] - '0';
+    return 0;
+}
+
+// Parses the params of one offer (s points after the extension name); returns false to decline the offer
+static bool parseoffer(const char* s, const char* e, struct wsdeflate_params* o) {
+    bool seen[4] = {false, false, false, false};
+    o->servernoctx = false;
+    o->clientnoctx = false;
+    o->serverbits = 15;
+    while (1) {
+        s = skipows(s);
+        if (s >= e) return true;
+        if (*s != ';') return false;
+        s = skipows(s + 1);
+        const char* ne = s;
+        while (ne < e && *ne != '=' && *ne != ';' && *ne != ' ' && *ne != '\t') ++ne;
+        const char* v = NULL;
+        const char* ve = NULL;
+        const char* t = skipows(ne);
+        if (t < e && *t == '=') {
+            v = skipows(t + 1);
+            ve = v;
+            while (ve < e && *ve != ';' && *ve != ' ' && *ve != '\t') ++ve;
+            t = ve;
+        }
+        int i;
+        if (tokeq(s, ne, "server_no_context_takeover")) i = 0;
+        else if (tokeq(s, ne, "client_no_context_takeover")) i = 1;
+        else if (tokeq(s, ne, "server_max_window_bits")) i = 2;
+        else if (tokeq(s, ne, "client_max_window_bits")) i = 3;
+        else return false;
+        if (seen[i]) return false;
+        seen[i] = true;
+        switch (i) {
+            case 0: if (v) return false; o->servernoctx = true; break;
+            case 1: if (v) return false; o->clientnoctx = true; break;
+            case 2: {
+                // raw deflate cannot be limited to a 256 byte window
+                unsigned b = (v) ? parsebits(v, ve) : 0;
+                if (b < 9) return false;
+                o->serverbits = b;
+            } break;
+            case 3:
+                // the inflater always uses the largest window, so whatever the client picks is fine
+                if (v && !parsebits(v, ve)) return false;
+                break;
+        }
+        s = t;
+    }
+}
+
+bool PSCHSL__WSNegotiateDeflate(const char* h, struct wsdeflate_params* o, char* resp, size_t respsz) {
+    while (*h) {
+        const char* oe = strchr(h, ',');
+        if (!oe) oe = h + strlen(h);
+        const char* s = skipows(h);
+        const char* ne = s;
+        while (ne < oe && *ne != ';' && *ne != ' ' && *ne != '\t') ++ne;
+        if (tokeq(s, ne, "permessage-deflate") && parseoffer(ne, oe, o)) {
+            int l = snprintf(
+                resp, respsz, "permessage-deflate%s%s",
+                (o->servernoctx) ? "; server_no_context_takeover" : "",
+                (o->clientnoctx) ? "; client_no_context_takeover" : ""
+            );
+            if (l < 0 || (size_t)l >= respsz) return false;
+            if (o->serverbits != 15) {
+                int l2 = snprintf(resp + l, respsz - l, "; server_max_window_bits=%u", (unsigned)o->serverbits);
+                if (l2 < 0 || (size_t)l2 >= respsz - l) return false;
+            }
+            return true;
+        }
+        if (!*oe) break;
+        h = oe + 1;
+    }
+    return false;
+}
+
+bool PSCHSL__WSDeflateInit(struct wsdeflate* d, const struct wsdeflate_params* p) {
+    d->params = *p;
+    memset(&d->inf, 0, sizeof(d->inf));
+    memset(&d->def, 0, sizeof(d->def));
+    if (zng_inflateInit2(&d->inf, -15) != Z_OK) return false;
+    int bits = -(int)p->serverbits;
+    if (zng_deflateInit2(&d->def, Z_DEFAULT_COMPRESSION, Z_DEFLATED, bits, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+        zng_inflateEnd(&d->inf);
+        return false;
+    }
+    return true;
+}
+
+void PSCHSL__WSDeflateFree(struct wsdeflate* d) {
+    zng_inflateEnd(&d->inf);
+    zng_deflateEnd(&d->def);
+}
+
+// Makes sure there is room to write to after out->len and returns how much (capped to what zlib-ng takes at once)
+static inline uint32_t zroom(struct charbuf* out) {
+    if (out->size - out->len < WS_ZCHUNK) {
+        size_t l = out->len;
+        if (!cb_addmultifake(out, WS_ZCHUNK)) return 0;
+        out->len = l;
+    }
+    size_t r = out->size - out->len;
+    return (r > UINT32_MAX) ? UINT32_MAX : r;
+}
+
+enum ws_result PSCHSL__WSInflate(struct wsdeflate* d, const uint8_t* in, size_t len, struct charbuf* out, size_t max) {
+    // the sender strips the empty stored block that ends each message, so it has to be added back
+    static const uint8_t tail[4] = {0x00, 0x00, 0xFF, 0xFF};
+    const uint8_t* srcs[2] = {in, tail};
+    size_t lens[2] = {len, 4};
+    enum ws_result res = WS_MESSAGE;
+    for (int i = 0; i < 2; ++i) {
+        size_t left = lens[i];
+        d->inf.next_in = srcs[i];
+        d->inf.avail_in = 0;
+        while (1) {
+            if (!d->inf.avail_in && left) {
+                uint32_t n = (left > UINT32_MAX) ? UINT32_MAX : left;
+                d->inf.avail_in = n;
+                left -= n;
+            }
+            uint32_t room = zroom(out);
+            if (!room) {
+                res = WS_ERRTOOBIG;
+                goto ret;
+            }
+            d->inf.next_out = (uint8_t*)out->data + out->len;
+            d->inf.avail_out = room;
+            int r = zng_inflate(&d->inf, Z_SYNC_FLUSH);
+            out->len += room - d->inf.avail_out;
+            if (out->len > max) {
+                res = WS_ERRTOOBIG;
+                goto ret;
+            }
+            if (r == Z_STREAM_END) {
+                // the sender ended the stream with a final block; the next message starts a new one
+                zng_inflateReset(&d->inf);
+                goto ret;
+            }
+            if (r != Z_OK && r != Z_BUF_ERROR) {
+                res = WS_ERRDATA;
+                goto ret;
+            }
+            if (d->inf.avail_out && !d->inf.avail_in && !left) break;
+        }
+    }
+    ret:;
+    if (d->params.clientnoctx && res == WS_MESSAGE) zng_inflateReset(&d->inf);
+    return res;
+}
+
+bool PSCHSL__WSDeflate(struct wsdeflate* d, const void* in, size_t len, struct charbuf* out) {
+    size_t start = out->len;
+    size_t left = len;
+    d->def.next_in = in;
+    d->def.avail_in = 0;
+    do {
+        if (!d->def.avail_in && left) {
+            uint32_t n = (left > UINT32_MAX) ? UINT32_MAX : left;
+            d->def.avail_in = n;
+            left -= n;
+        }
+        uint32_t room = zroom(out);
+        if (!room) return false;
+        d->def.next_out = (uint8_t*)out->data + out->len;
+        d->def.avail_out = room;
+        int r = zng_deflate(&d->def, (left) ? Z_NO_FLUSH : Z_SYNC_FLUSH);
+        out->len += room - d->def.avail_out;
+        if (r != Z_OK && r != Z_BUF_ERROR) return false;
+    } while (left || d->def.avail_in || !d->def.avail_out);
+    // drop the empty stored block the sync flush ends with; the receiver adds it back
+    if (out->len - start >= 4 && !memcmp(out->data + out->len - 4, "\x00\x00\xFF\xFF", 4)) out->len -= 4;
+    if (d->params.servernoctx) zng_deflateReset(&d->def);
+    return true;
+}
+
+bool PSCHSL__WSPoolInit(struct wspool* p, size_t max) {
+    if (!createMutex(&p->lock)) return false;
+    p->free = (max) ? malloc(max * sizeof(*p->free)) : NULL;
+    if (max && !p->free) {
+        destroyMutex(&p->lock);
+        return false;
+    }
+    p->count = 0;
+    p->max = max;
+    return true;
+}
+
+void PSCHSL__WSPoolFree(struct wspool* p) {
+    for (size_t i = 0; i < p->count; ++i) cb_dump(&p->free[i]);
+    free(p->free);
+    destroyMutex(&p->lock);
+}
+
+bool PSCHSL__WSPoolGet(struct wspool* p, struct charbuf* out) {
+    lockMutex(&p->lock);
+    if (p->count) {
+        *out = p->free[--p->count];
+        unlockMutex(&p->lock);
+        cb_clear(out);
+        return true;
+    }
+    unlockMutex(&p->lock);
+    return cb_init(out, 4096);
+}
+
+void PSCHSL__WSPoolPut(struct wspool* p, struct charbuf* b) {
+    // don't hold on to the memory of unusually large messages
+    if (b->size <= WS_POOLKEEPMAX) {
+        lockMutex(&p->lock);
+        if (p->count < p->max) {
+            p->free[p->count++] = *b;
+            unlockMutex(&p->lock);
+            return;
+        }
+        unlockMutex(&p->lock);
+    }
+    cb_dump(b);
+}
+
+// Appends to the message; it stays in the inline storage while it fits and moves into a pooled buffer after that
+static bool asmadd(struct wsasm* a, struct wspool* p, const uint8_t* d, size_t l) {
+    struct sbcharbuf* b = &a->buf;
+    if (b->data == b->inl && b->len + l > b->size) {
+        // pooled buffers start out much bigger than the inline storage, so the copy always fits
+        struct charbuf h;
+        if (!PSCHSL__WSPoolGet(p, &h)) return false;
+        memcpy(h.data, b->inl, b->len);
+        h.len = b->len;
+        sbcb_adopt(b, &h);
+    }
+    return sbcb_addpartstr(b, (const char*)d, l);
+}
+static inline void asmrelease(struct wsasm* a, struct wspool* p) {
+    struct charbuf h;
+    if (sbcb_release(&a->buf, &h)) PSCHSL__WSPoolPut(p, &h);
+}
+
+enum ws_result PSCHSL__WSAsmFeed(struct wsasm* a, struct wspool* p, const struct wsframe* f, const uint8_t* pl) {
+    if (f->opcode & 0x8) return WS_CONTROL;
+    if (f->opcode == WS_OP_CONT) {
+        // only the first frame of a message may carry RSV1
+        if (!a->active || f->rsv) return WS_ERRPROTO;
+    } else {
+        if (a->active || ((f->rsv & 0x40) && !a->deflate)) return WS_ERRPROTO;
+        if (f->len > a->max) return WS_ERRTOOBIG;
+        sbcb_clear(&a->buf);
+        a->active = true;
+        a->opcode = f->opcode;
+        a->compressed = (f->rsv & 0x40);
+    }
+    if (f->len > a->max - a->buf.len || (f->len && !asmadd(a, p, pl, f->len))) {
+        PSCHSL__WSAsmDone(a, p);
+        return WS_ERRTOOBIG;
+    }
+    if (!f->fin) return WS_INCOMPLETE;
+    if (a->compressed) {
+        struct charbuf out;
+        if (!a->deflate) {
+            PSCHSL__WSAsmDone(a, p);
+            return WS_ERRPROTO;
+        }
+        if (!PSCHSL__WSPoolGet(p, &out)) {
+            PSCHSL__WSAsmDone(a, p);
+            return WS_ERRTOOBIG;
+        }
+        enum ws_result r = PSCHSL__WSInflate(a->deflate, (const uint8_t*)a->buf.data, a->buf.len, &out, a->max);
+        asmrelease(a, p);
+        sbcb_adopt(&a->buf, &out);
+        if (r != WS_MESSAGE) {
+            PSCHSL__WSAsmDone(a, p);
+            return r;
+        }
+    }
+    if (a->opcode == WS_OP_TEXT && !PSCHSL__UTF8Valid((const uint8_t*)a->buf.data, a->buf.len)) {
+        PSCHSL__WSAsmDone(a, p);
+        return WS_ERRDATA;
+    }
+    return WS_MESSAGE;
+}
+
+void PSCHSL__WSAsmDone(struct wsasm* a, struct wspool* p) {
+    if (!a->active) return;
+    asmrelease(a, p);
+    a->active = false;
+}
@@ -0,0 +1,80 @@
+// Converts a PSCHSL_DumpTrace file to Chrome trace JSON (load it in chrome://tracing or Perfetto)
+//   - Build with: cc -I../src -o trace2json trace2json.c
+//   - Usage: trace2json <dump> [out.json]
+
+#include <pschsl/private/trace.h>
+#include <stdio.h>
+#include <string.h>
+
+static const char* const evnames[] = {"accept", "headers parsed", "callback", "callback", "first byte", "close"};
+static const char* const closenames[] = {"client", "done", "timeout", "error", "abort", "shed", "stop"};
+
+int main(int argc, char** argv) {
+    if (argc < 2 || argc > 3) {
+        fprintf(stderr, "Usage: %s <dump> [out.json]\n", argv[0]);
+        return 1;
+    }
+    FILE* in = fopen(argv[1], "rb");
+    if (!in) {
+        perror(argv[1]);
+        return 1;
+    }
+    FILE* out = (argc == 3) ? fopen(argv[2], "w") : stdout;
+    if (!out) {
+        perror(argv[2]);
+        return 1;
+    }
+    char magic[8];
+    uint32_t ver, recsz;
+    if (fread(magic, 1, 8, in) != 8 || memcmp(magic, TRACE_MAGIC, 8) ||
+        fread(&ver, sizeof(ver), 1, in) != 1 || fread(&recsz, sizeof(recsz), 1, in) != 1) {
+        fprintf(stderr, "%s: Not a trace dump\n", argv[1]);
+        return 1;
+    }
+    if (ver != TRACE_VERSION || recsz != sizeof(struct trace_rec)) {
+        fprintf(stderr, "%s: Unsupported trace version or byte order\n", argv[1]);
+        return 1;
+    }
+    fputs("{\"traceEvents\":[", out);
+    bool first = true;
+    uint32_t tid, count;
+    while (fread(&tid, sizeof(tid), 1, in) == 1 && fread(&count, sizeof(count), 1, in) == 1) {
+        bool incb = false;
+        for (uint32_t i = 0; i < count; ++i) {
+            struct trace_rec r;
+            if (fread(&r, sizeof(r), 1, in) != 1) {
+                fprintf(stderr, "%s: Truncated dump\n", argv[1]);
+                goto done;
+            }
+            if (r.event > TRACE_CLOSE) continue;
+            const char* ph = "i";
+            if (r.event == TRACE_CBSTART) {
+                ph = "B";
+                incb = true;
+            } else if (r.event == TRACE_CBEND) {
+                // the matching start may have been overwritten in the ring
+                if (!incb) continue;
+                ph = "E";
+                incb = false;
+            }
+            fprintf(
+                out, "%s\n{\"name\":\"%s\",\"ph\":\"%s\",%s\"ts\":%llu,\"pid\":1,\"tid\":%u,\"args\":{\"conn\":%u",
+                (first) ? "" : ",", evnames[r.event], ph, (*ph == 'i') ? "\"s\":\"t\"," : "",
+                (unsigned long long)r.time, (unsigned)tid, (unsigned)r.conn
+            );
+            if (r.event == TRACE_HDRSPARSED) fprintf(out, ",\"headers\":%u", (unsigned)r.arg);
+            else if (r.event == TRACE_CBEND) fprintf(out, ",\"status\":%u", (unsigned)r.arg);
+            else if (r.event == TRACE_CLOSE) {
+                if (r.arg < sizeof(closenames) / sizeof(*closenames)) fprintf(out, ",\"reason\":\"%s\"", closenames[r.arg]);
+                else fprintf(out, ",\"reason\":%u", (unsigned)r.arg);
+            }
+            fputs("}}", out);
+            first = false;
+        }
+    }
+    done:;
+    fputs("\n],\"displayTimeUnit\":\"ms\"}\n", out);
+    fclose(in);
+    if (out != stdout) fclose(out);
+    return 0;
+}